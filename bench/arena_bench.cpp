@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+
+#include <cracon/arena.hpp>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Counts the allocations of the JSON trees. Installed as the default
+// resource, it is the upstream of the arenas and of HeapJson.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  std::size_t allocations = 0;
+
+ private:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    allocations++;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *pointer, std::size_t bytes,
+                     std::size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+  }
+  bool do_is_equal(
+      std::pmr::memory_resource const &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+// Allocates each node from the default resource, as std::allocator would
+// from the heap.
+template <typename T>
+class HeapAllocator {
+ public:
+  using value_type = T;
+
+  HeapAllocator() noexcept = default;
+  template <typename U>
+  HeapAllocator(HeapAllocator<U> const &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(std::pmr::get_default_resource()->allocate(
+        n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *pointer, std::size_t n) noexcept {
+    std::pmr::get_default_resource()->deallocate(pointer, n * sizeof(T),
+                                                 alignof(T));
+  }
+
+  template <typename U>
+  bool operator==(HeapAllocator<U> const &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(HeapAllocator<U> const &) const noexcept {
+    return false;
+  }
+};
+
+using HeapJson =
+    nlohmann::basic_json<std::map, std::vector, std::string, bool,
+                         std::int64_t, std::uint64_t, double, HeapAllocator>;
+
+// Config of `modules` modules holding a few parameters and a lookup table.
+std::string make_config(int modules) {
+  auto config = nlohmann::json::object();
+  for (int module = 0; module < modules; module++) {
+    auto &group = config["module_" + std::to_string(module)];
+    group["gain"] = 1.5;
+    group["enabled"] = true;
+    group["nested"]["limits"]["max"] = 100;
+    for (int i = 0; i < 32; i++) {
+      group["table"].push_back(i * 0.25);
+    }
+  }
+  return config.dump(4);
+}
+
+// Baseline: each node, array and object allocated on the heap
+void BM_parse_heap(benchmark::State &state) {
+  auto const content = make_config(static_cast<int>(state.range(0)));
+  CountingResource counting;
+  auto *previous = std::pmr::set_default_resource(&counting);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HeapJson::parse(content));
+  }
+  std::pmr::set_default_resource(previous);
+  state.counters["allocations"] =
+      benchmark::Counter(static_cast<double>(counting.allocations),
+                         benchmark::Counter::kAvgIterations);
+  state.SetBytesProcessed(state.iterations() * content.size());
+}
+BENCHMARK(BM_parse_heap)->Arg(10)->Arg(5000)->Unit(benchmark::kMillisecond);
+
+// Parsing in an arena, reclaimed as a whole
+void BM_parse_arena(benchmark::State &state) {
+  auto const content = make_config(static_cast<int>(state.range(0)));
+  CountingResource counting;
+  auto *previous = std::pmr::set_default_resource(&counting);
+  for (auto _ : state) {
+    cracon::Arena arena;
+    cracon::ArenaScope scope(arena);
+    benchmark::DoNotOptimize(cracon::ArenaJson::parse(content));
+  }
+  std::pmr::set_default_resource(previous);
+  state.counters["allocations"] =
+      benchmark::Counter(static_cast<double>(counting.allocations),
+                         benchmark::Counter::kAvgIterations);
+  state.SetBytesProcessed(state.iterations() * content.size());
+}
+BENCHMARK(BM_parse_arena)->Arg(10)->Arg(5000)->Unit(benchmark::kMillisecond);
+
+}  // namespace
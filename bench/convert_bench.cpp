@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+
+#include <cracon/similarity_traits.hpp>
+#include <vector>
+
+namespace {
+
+nlohmann::json make_table(std::int64_t size) {
+  nlohmann::json table = nlohmann::json::array();
+  for (std::int64_t i = 0; i < size; i++) {
+    table.push_back(static_cast<double>(i) + 0.5);
+  }
+  return table;
+}
+
+// Only validates every element.
+void BM_is_similar(benchmark::State &state) {
+  auto const table = make_table(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cracon::is_similar<std::vector<float>>(table));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_is_similar)->RangeMultiplier(10)->Range(1000, 10000000);
+
+// Validates every element, then converts them.
+void BM_convert_two_pass(benchmark::State &state) {
+  auto const table = make_table(state.range(0));
+  for (auto _ : state) {
+    std::vector<float> values;
+    if (cracon::is_similar<std::vector<float>>(table)) {
+      values = table.get<std::vector<float>>();
+    }
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_convert_two_pass)->RangeMultiplier(10)->Range(1000, 10000000);
+
+// Validates and converts each element at once.
+void BM_convert_fused(benchmark::State &state) {
+  auto const table = make_table(state.range(0));
+  for (auto _ : state) {
+    std::vector<float> values;
+    benchmark::DoNotOptimize(cracon::try_get(table, values));
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_convert_fused)->RangeMultiplier(10)->Range(1000, 10000000);
+
+}  // namespace
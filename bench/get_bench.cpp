@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include <cracon/cracon.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+
+// Config holding "/module/group/value", all other keys are missing.
+cracon::File &make_file() {
+  static cracon::File file;
+  static bool const initialized = [] {
+    std::remove("bench_get.json");
+    file.init("bench_get.json", "bench_get_default.json");
+    (void)file.set("/module/group/value", 42);
+    return true;
+  }();
+  (void)initialized;
+  return file;
+}
+
+void BM_get_hit(benchmark::State &state) {
+  auto &file = make_file();
+  cracon::Key const key("/module/group/value");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(file.get(key, 0));
+  }
+}
+BENCHMARK(BM_get_hit)->ThreadRange(1, 8);
+
+void BM_get_miss(benchmark::State &state) {
+  auto &file = make_file();
+  cracon::Key const key("/module/group/missing");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(file.get(key, 0));
+  }
+}
+BENCHMARK(BM_get_miss)->ThreadRange(1, 8);
+
+void BM_get_miss_root(benchmark::State &state) {
+  auto &file = make_file();
+  cracon::Key const key("/missing/group/value");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(file.get(key, 0));
+  }
+}
+BENCHMARK(BM_get_miss_root)->ThreadRange(1, 8);
+
+// Deep key among many siblings, with (1) or without (0) the hash index.
+void BM_get_deep(benchmark::State &state) {
+  auto config = nlohmann::json::object();
+  for (int i = 0; i < 1000; i++) {
+    config["module_" + std::to_string(i)]["value"] = i;
+  }
+  config["module_500"]["a"]["b"]["c"]["d"]["e"] = 42;
+  std::ofstream("bench_get_deep.json") << config.dump();
+
+  cracon::Options options;
+  options.index = state.range(0) != 0;
+  cracon::File file;
+  file.init("bench_get_deep.json", "bench_get_deep_default.json", options);
+  cracon::Key const key("/module_500/a/b/c/d/e");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(file.get(key, 0));
+  }
+}
+BENCHMARK(BM_get_deep)->Arg(0)->Arg(1);
+
+}  // namespace
@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include <cracon/cracon.hpp>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// Holds "/level_0/.../level_<depth - 1>/value" for depths 1 to 8.
+cracon::SharedFile &make_file() {
+  static cracon::SharedFile file;
+  static bool const initialized = [] {
+    std::remove("bench_group.json");
+    file.init("bench_group.json", "bench_group_default.json");
+    std::string key;
+    for (int depth = 0; depth < 8; depth++) {
+      key += "/level_" + std::to_string(depth);
+      (void)file.set(key + "/value", depth);
+    }
+    return true;
+  }();
+  (void)initialized;
+  return file;
+}
+
+cracon::SharedFile::Group make_group(int depth) {
+  auto group = make_file().get_group("level_0");
+  for (int i = 1; i < depth; i++) {
+    group = group.get_group("level_" + std::to_string(i));
+  }
+  return group;
+}
+
+void BM_group_get(benchmark::State &state) {
+  auto group = make_group(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(group.get("value", 0));
+  }
+}
+BENCHMARK(BM_group_get)->RangeMultiplier(2)->Range(1, 8)->ThreadRange(1, 8);
+
+void BM_param_get(benchmark::State &state) {
+  auto param = make_group(4).get_param("value", 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(param.get());
+  }
+}
+BENCHMARK(BM_param_get)->ThreadRange(1, 8);
+
+void BM_realtime_param_get(benchmark::State &state) {
+  auto param = make_group(4).get_realtime_param("value", 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(param.get());
+  }
+}
+BENCHMARK(BM_realtime_param_get)->ThreadRange(1, 8);
+
+void BM_param_set(benchmark::State &state) {
+  auto param = make_group(4).get_param("value", 0);
+  int value = 0;
+  for (auto _ : state) {
+    param.set(value++);
+  }
+}
+BENCHMARK(BM_param_set)->ThreadRange(1, 8);
+
+}  // namespace
@@ -0,0 +1,125 @@
+#include <benchmark/benchmark.h>
+
+#include <cracon/cracon.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+// Writes a config of approximately `size` bytes made of modules holding
+// lookup tables and returns its filename.
+std::string make_config(std::size_t size) {
+  std::string filename = "bench_init_" + std::to_string(size) + ".json";
+  auto config = nlohmann::json::object();
+  std::size_t approximate_size = 0;
+  for (int module = 0; approximate_size < size; module++) {
+    auto &table = config["module_" + std::to_string(module)]["table"];
+    table = nlohmann::json::array();
+    for (int i = 0; i < 64; i++) {
+      table.push_back(i * 0.25);
+    }
+    approximate_size += 64 * 10;
+  }
+  std::ofstream(filename) << config.dump(4) << std::endl;
+  return filename;
+}
+
+// Baseline: parsing through the std::ifstream stream adapter
+void BM_parse_stream(benchmark::State &state) {
+  auto const filename = make_config(state.range(0));
+  for (auto _ : state) {
+    std::ifstream file(filename);
+    benchmark::DoNotOptimize(nlohmann::json::parse(file));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_parse_stream)
+    ->Arg(1 << 10)
+    ->Arg(1 << 20)
+    ->Arg(50 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+// Reading the file in a contiguous buffer first, as File::init does
+void BM_parse_buffer(benchmark::State &state) {
+  auto const filename = make_config(state.range(0));
+  for (auto _ : state) {
+    std::ifstream file(filename);
+    file.seekg(0, std::ios::end);
+    std::string content(static_cast<std::size_t>(file.tellg()), '\0');
+    file.seekg(0, std::ios::beg);
+    file.read(content.data(), content.size());
+    benchmark::DoNotOptimize(nlohmann::json::parse(
+        content.data(), content.data() + content.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_parse_buffer)
+    ->Arg(1 << 10)
+    ->Arg(1 << 20)
+    ->Arg(50 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_init(benchmark::State &state) {
+  auto const filename = make_config(state.range(0));
+  for (auto _ : state) {
+    cracon::File file;
+    benchmark::DoNotOptimize(file.init(filename, "bench_init_default.json"));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_init)
+    ->Arg(1 << 10)
+    ->Arg(1 << 20)
+    ->Arg(50 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+// Loading the CBOR sidecar instead of parsing the JSON
+void BM_init_sidecar(benchmark::State &state) {
+  auto const filename = make_config(state.range(0));
+  cracon::Options options;
+  options.sidecar = cracon::Sidecar::cbor;
+  {
+    cracon::File file;  // Generates the sidecar
+    file.init(filename, "bench_init_default.json", options);
+  }
+  for (auto _ : state) {
+    cracon::File file;
+    benchmark::DoNotOptimize(
+        file.init(filename, "bench_init_default.json", options));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_init_sidecar)
+    ->Arg(1 << 10)
+    ->Arg(1 << 20)
+    ->Arg(50 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+// The same config split in a directory, one file per module
+void BM_init_directory(benchmark::State &state) {
+  auto const filename = make_config(state.range(0));
+  std::string const directory = "bench_init_" +
+                                std::to_string(state.range(0)) + ".d/";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  for (auto const &module :
+       nlohmann::json::parse(std::ifstream(filename)).items()) {
+    std::ofstream(directory + module.key() + ".json")
+        << module.value().dump(4) << std::endl;
+  }
+  for (auto _ : state) {
+    cracon::File file;
+    benchmark::DoNotOptimize(file.init(directory, "bench_init_default.json"));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_init_directory)
+    ->Arg(1 << 10)
+    ->Arg(1 << 20)
+    ->Arg(50 << 20)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
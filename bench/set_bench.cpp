@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+
+#include <cracon/cracon.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<cracon::Key> make_keys() {
+  std::vector<cracon::Key> keys;
+  for (int i = 0; i < 200; i++) {
+    keys.emplace_back("/module_" + std::to_string(i % 20) + "/value_" +
+                      std::to_string(i));
+  }
+  return keys;
+}
+
+// Applies 200 changes with one set() each.
+void BM_set_each(benchmark::State &state) {
+  std::remove("bench_set.json");
+  cracon::File file;
+  file.init("bench_set.json", "bench_set_default.json");
+  auto const keys = make_keys();
+  int value = 0;
+  for (auto _ : state) {
+    for (auto const &key : keys) {
+      (void)file.set(key, value);
+    }
+    value++;
+  }
+}
+BENCHMARK(BM_set_each);
+
+// Applies the same 200 changes in a single transaction.
+void BM_set_transaction(benchmark::State &state) {
+  std::remove("bench_set.json");
+  cracon::File file;
+  file.init("bench_set.json", "bench_set_default.json");
+  auto const keys = make_keys();
+  int value = 0;
+  for (auto _ : state) {
+    auto transaction = file.transaction();
+    for (auto const &key : keys) {
+      (void)transaction.set(key, value);
+    }
+    transaction.commit();
+    value++;
+  }
+}
+BENCHMARK(BM_set_transaction);
+
+// Each thread sets the keys of its own module, as modules of an application
+// would. Measures the throughput of sets from concurrent threads, which only
+// copy and lock their own module.
+void BM_set_contended(benchmark::State &state) {
+  static cracon::File file;
+  static bool const initialized = [] {
+    std::remove("bench_set_contended.json");
+    file.init("bench_set_contended.json", "bench_set_contended_default.json");
+    for (auto const &key : make_keys()) {
+      (void)file.set(key, 0);
+    }
+    return true;
+  }();
+  (void)initialized;
+  auto const module = "/module_" + std::to_string(state.thread_index());
+  std::vector<cracon::Key> keys;
+  for (int i = 0; i < 10; i++) {
+    keys.emplace_back(module + "/value_" + std::to_string(i));
+  }
+  int value = 0;
+  for (auto _ : state) {
+    (void)file.set(keys[value % keys.size()], value);
+    value++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_set_contended)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace
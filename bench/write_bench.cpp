@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+
+#include <cracon/cracon.hpp>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// Config of `modules` modules holding a 64 values table each.
+void fill(cracon::File &file, std::int64_t modules) {
+  std::vector<double> table(64, 0.25);
+  auto transaction = file.transaction();
+  for (std::int64_t module = 0; module < modules; module++) {
+    (void)transaction.set("/module_" + std::to_string(module) + "/table",
+                          table);
+  }
+  transaction.commit();
+}
+
+// A change is written each iteration.
+void BM_write(benchmark::State &state) {
+  std::string const filename =
+      "bench_write_" + std::to_string(state.range(0)) + ".json";
+  std::remove(filename.c_str());
+  cracon::File file;
+  file.init(filename, "bench_write_default.json");
+  fill(file, state.range(0));
+  int value = 0;
+  for (auto _ : state) {
+    (void)file.set("/value", value++);
+    benchmark::DoNotOptimize(file.write());
+  }
+}
+BENCHMARK(BM_write)->Arg(1)->Arg(100)->Arg(10000)->Unit(
+    benchmark::kMicrosecond);
+
+// The content is already on disk, the write is skipped.
+void BM_write_unchanged(benchmark::State &state) {
+  std::string const filename =
+      "bench_write_" + std::to_string(state.range(0)) + ".json";
+  std::remove(filename.c_str());
+  cracon::File file;
+  file.init(filename, "bench_write_default.json");
+  fill(file, state.range(0));
+  file.write();
+  for (auto _ : state) {
+    (void)file.set("/value", 0);
+    benchmark::DoNotOptimize(file.write());
+  }
+}
+BENCHMARK(BM_write_unchanged)
+    ->Arg(1)
+    ->Arg(100)
+    ->Arg(10000)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,125 @@
+#ifndef CRACON_ARENA_HPP
+#define CRACON_ARENA_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace cracon {
+
+/**
+ * @brief Memory of JSON trees, reclaimed as a whole once the arena is
+ * destroyed.
+ *
+ * Allocating is bumping an offset within the current block and freeing does
+ * nothing, thus a large configuration is parsed without a heap allocation per
+ * node and doesn't fragment the heap. The arena must outlive the trees
+ * allocated in it. It can be shared by threads: the offset is bumped
+ * atomically, only adding a block takes a lock.
+ */
+class Arena {
+ public:
+  explicit Arena(std::size_t initial_size = 64 << 10)
+      : next_size_(initial_size) {}
+  ~Arena();
+  Arena(Arena const &) = delete;
+  Arena &operator=(Arena const &) = delete;
+
+  // Alignments up to alignof(std::max_align_t) are supported.
+  void *allocate(std::size_t size, std::size_t alignment);
+
+  /**
+   * @brief Bytes allocated in the arena so far.
+   */
+  [[nodiscard]] std::size_t allocated() const {
+    return allocated_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Block;
+  // Makes a block of at least size bytes the current one, unless another
+  // thread replaced full meanwhile.
+  void grow(Block *full, std::size_t size);
+
+  std::atomic<Block *> current_ = nullptr;
+  std::atomic<std::size_t> allocated_ = 0;
+  // Taken to add a block.
+  std::mutex mutex_;
+  // Doubled for each block, as std::pmr::monotonic_buffer_resource does.
+  std::size_t next_size_;
+};
+
+/**
+ * @brief Allocates in the arena of the current thread, see ArenaScope, or on
+ * the heap outside of any scope.
+ */
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena &arena);
+  ~ArenaScope();
+  ArenaScope(ArenaScope const &) = delete;
+  ArenaScope &operator=(ArenaScope const &) = delete;
+
+ private:
+  Arena *previous_;
+};
+
+namespace detail {
+// Each block starts with a header holding its arena, nullptr for the heap, so
+// that any allocator frees any block.
+void *arena_allocate(std::size_t size);
+void arena_deallocate(void *pointer) noexcept;
+}  // namespace detail
+
+/**
+ * @brief Stateless allocator of the current ArenaScope.
+ *
+ * nlohmann::basic_json default constructs its allocators, thus the arena is
+ * found from the thread instead of being stored. Trees copied outside of a
+ * scope, i.e. by File::set, allocate on the heap.
+ */
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator() noexcept = default;
+  template <typename U>
+  ArenaAllocator(ArenaAllocator<U> const &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "Over-aligned types are not supported");
+    return static_cast<T *>(detail::arena_allocate(n * sizeof(T)));
+  }
+  void deallocate(T *pointer, std::size_t) noexcept {
+    detail::arena_deallocate(pointer);
+  }
+
+  template <typename U>
+  bool operator==(ArenaAllocator<U> const &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(ArenaAllocator<U> const &) const noexcept {
+    return false;
+  }
+};
+
+/**
+ * @brief nlohmann::json whose objects and arrays are allocated with
+ * ArenaAllocator. Strings longer than the small string buffer stay on the
+ * heap, as nlohmann::json converts them from and to std::string.
+ */
+using ArenaJson =
+    nlohmann::basic_json<std::map, std::vector, std::string, bool,
+                         std::int64_t, std::uint64_t, double, ArenaAllocator>;
+
+}  // namespace cracon
+
+#endif  // CRACON_ARENA_HPP
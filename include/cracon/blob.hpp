@@ -0,0 +1,105 @@
+#ifndef CRACON_BLOB_HPP
+#define CRACON_BLOB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace cracon {
+template <typename JsonT>
+class basic_File;
+
+namespace detail {
+/**
+ * @brief Read-only content of a file, memory mapped where supported (POSIX),
+ * read in memory otherwise.
+ */
+class MappedFile {
+ public:
+  /**
+   * @brief Maps the file, nullptr if it can't be opened.
+   */
+  static std::shared_ptr<MappedFile const> open(std::string const &filename);
+  MappedFile() = default;
+  MappedFile(MappedFile const &) = delete;
+  MappedFile &operator=(MappedFile const &) = delete;
+  ~MappedFile();
+
+  [[nodiscard]] char const *data() const { return data_; }
+  [[nodiscard]] std::size_t size() const { return size_; }
+
+ private:
+  char const *data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+  std::unique_ptr<char[]> buffer_;
+};
+
+/**
+ * @brief Name of the element type of a blob, i.e. "f32" for float.
+ */
+template <typename T>
+constexpr char const *dtype_name() {
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                "Blobs hold numbers");
+  if constexpr (std::is_floating_point_v<T>) {
+    return sizeof(T) == 4 ? "f32" : "f64";
+  } else if constexpr (std::is_signed_v<T>) {
+    return sizeof(T) == 1   ? "i8"
+           : sizeof(T) == 2 ? "i16"
+           : sizeof(T) == 4 ? "i32"
+                            : "i64";
+  } else {
+    return sizeof(T) == 1   ? "u8"
+           : sizeof(T) == 2 ? "u16"
+           : sizeof(T) == 4 ? "u32"
+                            : "u64";
+  }
+}
+}  // namespace detail
+
+/**
+ * @brief Numeric table stored in an external raw binary file, see
+ * File::get_blob.
+ *
+ * The data is read in place from the mapped file, in the native byte order.
+ * The mapping stays valid as long as the Blob (or a copy) exists, even if the
+ * blob is replaced meanwhile.
+ */
+template <typename T>
+class Blob {
+ public:
+  Blob() = default;
+
+  /**
+   * @brief True if the blob was found and matches the type.
+   */
+  explicit operator bool() const { return file_ != nullptr; }
+  [[nodiscard]] T const *data() const { return data_; }
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  /**
+   * @brief The dimensions of the table, their product is size().
+   */
+  [[nodiscard]] std::vector<std::size_t> const &shape() const {
+    return shape_;
+  }
+  T const &operator[](std::size_t i) const { return data_[i]; }
+  T const *begin() const { return data_; }
+  T const *end() const { return data_ + size_; }
+
+ private:
+  template <typename JsonT>
+  friend class basic_File;
+  std::shared_ptr<detail::MappedFile const> file_;
+  T const *data_ = nullptr;
+  std::size_t size_ = 0;
+  std::vector<std::size_t> shape_;
+};
+
+}  // namespace cracon
+
+#endif  // CRACON_BLOB_HPP
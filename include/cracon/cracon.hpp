@@ -1,136 +1,875 @@
 #ifndef CRACON_CRACON_HPP
 #define CRACON_CRACON_HPP
 
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cracon/arena.hpp>
+#include <cracon/blob.hpp>
+#include <cracon/fields.hpp>
+#include <cracon/key.hpp>
 #include <cracon/log.hpp>
+#include <cracon/seqlock.hpp>
 #include <cracon/similarity_traits.hpp>
+#include <cracon/stats.hpp>
+#include <cracon/view.hpp>
+#include <cstdint>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace cracon {
-class File {
+
+/**
+ * @brief Binary encodings of the configuration, see Options::sidecar.
+ */
+enum class Sidecar { none, cbor, msgpack };
+
+/**
+ * @brief Optional features of a File, chosen at init.
+ */
+struct Options {
+  // Keeps a flat hash index from each key to its value, thus a lookup is a
+  // single probe whatever the depth of the key. It costs memory and each
+  // change rebuilds the index of its module.
+  bool index = false;
+  // Writes the files from a background thread once changes settled for
+  // write_behind_debounce, instead of waiting for write(). Pending changes are
+  // written when the File is destroyed. See File::flush().
+  bool write_behind = false;
+  std::chrono::milliseconds write_behind_debounce{100};
+  // Keeps a binary copy of the configuration next to it, i.e. config.json.cbor,
+  // loaded instead of parsing the JSON when the JSON didn't change. The JSON
+  // stays the reference: a stale sidecar is regenerated.
+  Sidecar sidecar = Sidecar::none;
+  // Reloads the configuration when the file is changed by another process,
+  // notifying the subscribers of the changed keys, see File::subscribe. Only
+  // supported on Linux (inotify).
+  bool watch = false;
+  // Files overlaid below the configuration file, from the lowest, i.e. base,
+  // site then host. The configuration file is the top layer, the only one
+  // changed by set() and written. Objects are merged, other values replace
+  // those of the lower layers and null removes them (JSON merge patch). Read
+  // once by init(), missing layers are skipped.
+  std::vector<std::string> layers;
+};
+
+/**
+ * @brief Configuration file, see File.
+ *
+ * @tparam JsonT The nlohmann::basic_json holding the configuration, i.e.
+ * nlohmann::ordered_json to keep the keys in insertion order or ArenaJson to
+ * parse in an arena.
+ */
+template <typename JsonT>
+class basic_File {
  public:
-  File() {}
-  File(std::string const &filename_config, std::string const &filename_default);
+  using json_type = JsonT;
+
+  /**
+   * @brief Immutable state of the configuration at a given generation.
+   *
+   * Readers hold a shared_ptr to a snapshot, thus a concurrent set() never
+   * modifies the data being read, it publishes a new generation instead. The
+   * configuration is split in modules, its top-level values, shared by the
+   * snapshots until they change: a set() copies the module of its key only.
+   */
+  struct Snapshot {
+    struct IndexEntry {
+      std::string path;
+      JsonT const *value;
+    };
+    using Index = std::unordered_map<std::uint64_t, IndexEntry>;
+
+    /**
+     * @brief A top-level value of the configuration.
+     */
+    struct Module {
+      // Memory of the trees parsed for this module, if JsonT allocates in
+      // arenas (ArenaJson). Copies, i.e. by set(), are allocated on the heap.
+      // Declared first to be destroyed after the trees.
+      std::shared_ptr<Arena> arena;
+      // The value, nullopt if the configuration file removes it from the
+      // layers.
+      std::optional<JsonT> value;
+      // Its value in the configuration file if Options::layers, value being
+      // then the merged view. nullopt if the file doesn't have it.
+      std::optional<JsonT> layer;
+      // Keeps the modules in the order of the file, see nlohmann::ordered_json.
+      std::uint64_t order = 0;
+      // From Key::hash() to the values within value. Only used if indexed.
+      Index index;
+      bool indexed = false;
+    };
+
+    // The modules by name, none if the configuration isn't an object.
+    std::map<std::string, std::shared_ptr<Module const>, std::less<>> modules;
+    // False if the configuration isn't an object, config() holding it all.
+    bool object = true;
+    // True if Options::layers.
+    bool layered = false;
+    std::uint64_t generation = 0;
+    // Modules changed since the snapshot this one is a copy of, all of them if
+    // all_changed. Marked to be written once it is published.
+    std::vector<std::string> changed_modules;
+    bool all_changed = false;
+
+    /**
+     * @brief Finds the value at the key without throwing, nullptr if missing.
+     */
+    [[nodiscard]] JsonT const *find(Key const &key) const {
+      auto const &tokens = key.tokens();
+      if (tokens.empty() || !object) {
+        return cracon::find(config(), key);
+      }
+      auto const it = modules.find(tokens.front());
+      if (it == modules.end() || !it->second->value) {
+        return nullptr;
+      }
+      auto const &module = *it->second;
+      if (module.indexed) {
+        auto entry = module.index.find(key.hash());
+        if (entry == module.index.end()) {
+          return nullptr;
+        }
+        if (entry->second.path == key.str()) {
+          return entry->second.value;
+        }
+        // Hash collision, too rare to be worth handling in the index.
+      }
+      return cracon::find(*module.value, key, 1);
+    }
+
+    /**
+     * @brief The whole configuration, assembled from the modules once needed.
+     */
+    [[nodiscard]] JsonT const &config() const {
+      return assemble(config_, false);
+    }
+
+    /**
+     * @brief The content of the configuration file.
+     */
+    [[nodiscard]] JsonT const &file_content() const {
+      return layered ? assemble(file_content_, true) : config();
+    }
+
+   private:
+    friend class basic_File;
+    // The modules in a single tree, cached by the first call.
+    JsonT const &assemble(std::shared_ptr<JsonT const> &cache,
+                          bool file) const;
+
+    // Set once assembled, or if the configuration isn't an object.
+    mutable std::shared_ptr<JsonT const> config_;
+    mutable std::shared_ptr<JsonT const> file_content_;
+  };
+
+  /**
+   * @brief Read-only value pointing into a snapshot, see File::get_view.
+   *
+   * The view keeps its snapshot alive, thus it stays valid and unchanged as
+   * long as the view exists, whatever happens to the File. Don't keep the
+   * string_view or ArrayView after the View is destroyed.
+   */
+  template <typename T>
+  class View {
+   public:
+    View() = default;
+
+    /**
+     * @brief True if the key exists and has the right type.
+     */
+    explicit operator bool() const { return snapshot_ != nullptr; }
+    T const &operator*() const {
+      assert(snapshot_ != nullptr);
+      return value_;
+    }
+    T const *operator->() const {
+      assert(snapshot_ != nullptr);
+      return &value_;
+    }
+
+   private:
+    friend class basic_File;
+    std::shared_ptr<Snapshot const> snapshot_;
+    T value_{};
+  };
+
+  /**
+   * @brief Called when a reload changes the value of a key.
+   */
+  using Listener = std::function<void()>;
+
+  /**
+   * @brief Counters of the File activity since its creation.
+   */
+  struct Stats {
+    // Reads of a value: get(), Transaction::get() and each field of bind()
+    std::uint64_t gets = 0;
+    // Reads returning the configured value
+    std::uint64_t hits = 0;
+    // Reads of a missing key, returning the default
+    std::uint64_t misses = 0;
+    // Reads of a value of another type, returning the default
+    std::uint64_t type_mismatches = 0;
+    // Changes: set(), store() and Transaction::set()
+    std::uint64_t sets = 0;
+    // Files written to the disk
+    std::uint64_t writes = 0;
+    // Writes skipped as the file already had the same content
+    std::uint64_t skipped_writes = 0;
+    std::uint64_t bytes_written = 0;
+    // Duration of write()
+    Histogram write_latency;
+    // Time spent waiting for the writers lock
+    Histogram lock_wait;
+  };
+
+  /**
+   * @brief Batch of gets and sets applied as a single change.
+   *
+   * The transaction holds the File lock until it is destroyed, thus other
+   * writers wait. Sets are published at once by commit(): readers never see
+   * part of them. Each module is copied once for the whole batch instead of
+   * once per set. Uncommitted sets are discarded.
+   */
+  class Transaction {
+   public:
+    Transaction(Transaction &&) = default;
+    Transaction(Transaction const &) = delete;
+    Transaction &operator=(Transaction const &) = delete;
+
+    /**
+     * @brief Same as File::get(), seeing the sets of this transaction.
+     */
+    template <typename T>
+    [[nodiscard]] auto get(Key const &key, T const &default_val) -> T {
+      file_->record_default(key, default_val);
+      if (next_ != nullptr) {
+        return file_->convert(next_->find(key), key, default_val);
+      }
+      return file_->convert(file_->snapshot()->find(key), key, default_val);
+    }
+
+    /**
+     * @brief Same as File::set(), published on commit().
+     */
+    template <typename T>
+    auto set(Key const &key, T const &new_value) -> T {
+      if (next_ == nullptr) {
+        next_ = file_->next_snapshot();
+      }
+      file_->apply(*next_, key, [&](JsonT &config) {
+        assign(config, key, new_value);
+      });
+      file_->sets_.fetch_add(1, std::memory_order_relaxed);
+      return new_value;
+    }
+
+    /**
+     * @brief Publishes the sets as a single new generation.
+     *
+     * The transaction can be used again afterwards.
+     */
+    void commit() {
+      if (next_ == nullptr) {
+        return;
+      }
+      file_->publish(std::move(next_));
+      next_.reset();
+      file_->should_write_config_ = true;
+      file_->notify_change();
+    }
+
+   private:
+    friend class basic_File;
+    explicit Transaction(basic_File &file)
+        : file_(&file), lock_(file.lock_config()) {}
+
+    basic_File *file_;
+    std::unique_lock<std::shared_mutex> lock_;
+    // Copy of the configuration with the pending sets, if any.
+    std::shared_ptr<Snapshot> next_;
+  };
+
+  basic_File() {}
+  basic_File(std::string const &filename_config,
+             std::string const &filename_default,
+             Options const &options = {});
+  ~basic_File();
   /**
    * @brief Sets the configuration filenames and parses them if it exists.
    *
    * Create the files otherwise. Returns false if it failed to be created/read.
+   * Existing files are only written once their content changes.
+   *
+   * The configuration can be split in a directory (an existing one or a path
+   * ending with '/'): each *.json file is a module, i.e. conf.d/car.json is
+   * /car. The files are parsed in parallel and only the modules changed are
+   * written back. Setting a module whose name contains '/' throws
+   * std::invalid_argument.
    *
-   * @param filename_config The json file to to read or create
+   * @param filename_config The json file (or directory) to read or create
    * @param filename_default The default configuration file to create
+   * @param options Optional features, see Options
    * @return true File loaded or created
    * @return false File couldn't be read or created
    */
   bool init(std::string const &filename_config,
-            std::string const &filename_default);
+            std::string const &filename_default, Options const &options = {});
   /**
    * @brief True if we the local representation differs from the files.
    */
   bool should_write() { return should_write_default_ || should_write_config_; }
 
+  /**
+   * @brief Stops (or resumes) recording the defaults in get().
+   *
+   * Once all parameters have been read at startup, freezing the defaults makes
+   * get() a pure read of the configuration.
+   */
+  void freeze_defaults(bool frozen = true) { defaults_frozen_ = frozen; }
+
+  /**
+   * @brief The current configuration, without taking the File lock: readers
+   * never wait for a writer copying or modifying the configuration.
+   *
+   * The snapshot stays valid and unchanged as long as it is held. Loading it
+   * is not lock-free on libstdc++ nor MSVC, where std::atomic_load of a
+   * shared_ptr takes a short lock from a global pool; read from realtime
+   * threads with RealtimeParam.
+   */
+  [[nodiscard]] std::shared_ptr<Snapshot const> snapshot() const {
+    return std::atomic_load(&snapshot_);
+  }
+
+  /**
+   * @brief The generation of the configuration, incremented on each change.
+   */
+  [[nodiscard]] std::uint64_t generation() const {
+    return snapshot()->generation;
+  }
+
+  /**
+   * @brief Re-reads the configuration file if it changed on disk.
+   *
+   * Local changes not written yet are discarded. The subscribers of the keys
+   * whose value changed are notified, after the new generation is published.
+   *
+   * @return true The configuration is up to date with the file
+   * @return false The file couldn't be read or parsed
+   */
+  bool reload();
+
+  /**
+   * @brief Calls listener when a reload changes the value at key, one of its
+   * children or one of its parents.
+   *
+   * Listeners are called from the thread reloading the configuration.
+   *
+   * @return The subscription; the listener is removed once it is released.
+   */
+  [[nodiscard]] std::shared_ptr<Listener> subscribe(Key const &key,
+                                                    Listener listener);
+
+  /**
+   * @brief True if Options::watch reloads the configuration on changes.
+   */
+  [[nodiscard]] bool watching() const { return watching_; }
+
+  /**
+   * @brief Starts a batch of gets and sets, see Transaction.
+   *
+   * Do not call set() or another transaction() from the same thread while the
+   * transaction exists, it would deadlock.
+   */
+  [[nodiscard]] Transaction transaction() { return Transaction(*this); }
+
+  /**
+   * @brief The activity counters, see Stats.
+   */
+  [[nodiscard]] Stats stats() const;
+
   /**
    * @brief Set a parameter value
    *
    * If the value is dissimilar, it will crash (assert(false)) in debug mode.
    *
    * @tparam T Type of the parameter
-   * @param accessor The json pointer in the form "/some_module/some_parameter"
+   * @param key The json pointer in the form "/some_module/some_parameter"
    * @param new_value The value to write
    * @return The new value to be saved locally
    */
   template <typename T>
-  [[nodiscard]] auto set(std::string const &accessor, T const &new_value) -> T {
-    std::unique_lock lock(mutex_);
-
-    nlohmann::json::json_pointer pointer(accessor);
-    auto &val = config_[pointer];
-    should_write_config_ = true;
-    val = new_value;
-    if (val.is_null()) {
-      CRACON_LOG_WARNING("The key didn't exist for %s\n", accessor.c_str());
-    } else {
-      if (!is_similar<T>(val)) {
-        CRACON_LOG_WARNING(
-            "The new key is not a similar type to the precedent configuration: "
-            "%s replaced by %s\n",
-            accessor.c_str(), val.dump().c_str());
-      }
-    }
+  [[nodiscard]] auto set(Key const &key, T const &new_value) -> T {
+    sets_.fetch_add(1, std::memory_order_relaxed);
+    apply_change(
+        key, [&](JsonT &config) { assign(config, key, new_value); });
     return new_value;
   }
 
   /**
    * @brief Get the value of a parameter.
    *
-   * Set the default value in the defaults.
+   * Set the default value in the defaults, unless frozen. The defaults file
+   * only needs writing if the default changed.
    * If the value is null, create it, update the json.
    * If the value is not similar (different type), update it and print an error.
    * Else return the parsed value.
    *
+   * The configuration is read from the current snapshot, without taking the
+   * File lock, see snapshot().
+   *
    * @tparam T Type of the parameter
-   * @param accessor The location of the data within the JSON
+   * @param key The location of the data within the JSON
    * @param default_val A default value if the data at the pointer doesn't exist
    * @return T Either the data in the JSON or the default value
    */
   template <typename T>
-  [[nodiscard]] auto get(std::string const &accessor, T const &default_val)
-      -> T {
-    std::unique_lock lock(mutex_);
-
-    nlohmann::json::json_pointer pointer(accessor);
-    default_[pointer] = default_val;
-    should_write_default_ = true;
-    try {
-      auto &val = config_.at(pointer);
-      if (val.is_null()) {
-        CRACON_LOG_INFO(
-            "The requested key doesn't exist for %s defaulted "
-            "to \n",
-            default_[pointer].dump().c_str());
-        return default_val;
+  [[nodiscard]] auto get(Key const &key, T const &default_val) -> T {
+    record_default(key, default_val);
+
+    auto const current = snapshot();
+    return convert(current->find(key), key, default_val);
+  }
+
+  /**
+   * @brief Reads a value without copying it out of the configuration.
+   *
+   * Supports std::string_view for strings and ArrayView<T> for arrays of
+   * numbers or booleans. Unlike get(), there is no default: the view is empty
+   * if the key is missing or has another type, and nothing is recorded.
+   *
+   * @tparam T std::string_view or ArrayView<T>
+   * @param key The location of the data within the JSON
+   * @return View<T> A view valid as long as it is held, see View
+   */
+  template <typename T>
+  [[nodiscard]] View<T> get_view(Key const &key) const {
+    static_assert(
+        std::is_same_v<T, std::string_view> || is_array_view<T>::value,
+        "get_view supports std::string_view and ArrayView");
+    View<T> view;
+    auto current = snapshot();
+    auto const *val = current->find(key);
+    if (val == nullptr) {
+      return view;
+    }
+    if constexpr (std::is_same_v<T, std::string_view>) {
+      if (!val->is_string()) {
+        return view;
+      }
+      view.value_ = val->template get_ref<std::string const &>();
+    } else {
+      static_assert(
+          std::is_same_v<T, ArrayView<typename T::value_type, JsonT>>,
+          "The ArrayView must be of the JSON type of the File");
+      if (!is_similar<std::vector<typename T::value_type>>(*val)) {
+        return view;
       }
-      // This can happen if: The config file is the wrong type or the code is
-      // using the wrong type; It is considered the code is right;
+      view.value_ = T(val->template get_ref<typename JsonT::array_t const &>());
+    }
+    view.snapshot_ = std::move(current);
+    return view;
+  }
+
+  /**
+   * @brief Reads a numeric table stored in an external binary file.
+   *
+   * The JSON holds a reference to the file, relative to the configuration
+   * file: {"$blob": "motor_curve.f32", "dtype": "f32", "shape": [24]}. The
+   * dtype defaults to the extension of the file. The file is mapped, not
+   * copied.
+   *
+   * @tparam T Element type, matching the dtype
+   * @param key The location of the reference within the JSON
+   * @return Blob<T> Empty if the reference or the file is missing or invalid
+   */
+  template <typename T>
+  [[nodiscard]] Blob<T> get_blob(Key const &key) const {
+    Blob<T> blob;
+    auto const current = snapshot();
+    auto const *reference = current->find(key);
+    if (reference == nullptr) {
+      return blob;
+    }
+    auto file =
+        open_blob(*reference, detail::dtype_name<T>(), sizeof(T), blob.shape_);
+    if (file == nullptr) {
+      return blob;
+    }
+    blob.data_ = reinterpret_cast<T const *>(file->data());
+    blob.size_ = file->size() / sizeof(T);
+    blob.file_ = std::move(file);
+    return blob;
+  }
+
+  /**
+   * @brief Stores a numeric table in an external binary file and sets its
+   * reference at key, see get_blob.
+   *
+   * The binary file is replaced right away, unless it already holds the same
+   * data; the reference is written with the configuration. Blobs being read
+   * keep the previous data.
+   *
+   * @param key The location of the reference within the JSON
+   * @param blob_filename The binary file, relative to the configuration file
+   * @param data The table, in row-major order
+   * @param shape The dimensions of the table, {data.size()} by default
+   * @return true The blob is stored
+   * @return false The shape doesn't match or the file couldn't be written
+   */
+  template <typename T>
+  bool set_blob(Key const &key, std::string const &blob_filename,
+                std::vector<T> const &data,
+                std::vector<std::size_t> shape = {}) {
+    if (shape.empty()) {
+      shape.push_back(data.size());
+    }
+    std::size_t elements = 1;
+    for (auto dimension : shape) {
+      elements *= dimension;
+    }
+    if (elements != data.size()) {
+      CRACON_LOG_ERROR("The shape of %s doesn't match its %zu elements\n",
+                       blob_filename.c_str(), data.size());
+      return false;
+    }
+    return write_blob(key, blob_filename, detail::dtype_name<T>(),
+                      data.data(), data.size() * sizeof(T), shape);
+  }
+
+  /**
+   * @brief Loads the fields of a struct declared with CRACON_STRUCT.
+   *
+   * The current values of the fields are the defaults. The group at key is
+   * found once and all the defaults are recorded at once, instead of one get()
+   * per field. Missing or dissimilar fields keep their default.
+   *
+   * @param key The location of the group of fields within the JSON
+   * @param object The struct to fill
+   */
+  template <typename T>
+  void bind(Key const &key, T &object) {
+    record_defaults(key, object);
+
+    auto const current = snapshot();
+    auto const *group = current->find(key);
+    if (group == nullptr || !group->is_object()) {
+      CRACON_LOG_KEYED_INFO(key.hash(),
+                            "The requested group doesn't exist for %s\n",
+                            key.str().c_str());
+      cracon_fields(object, [&](char const *, auto const &) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+      });
+      return;
+    }
+    cracon_fields(object, [&](char const *name, auto &value) {
+      using Field = std::decay_t<decltype(value)>;
+      auto it = group->find(name);
+      if (it == group->end() || it->is_null()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      Field converted;
+      if (!try_get(*it, converted)) {
+        type_mismatches_.fetch_add(1, std::memory_order_relaxed);
+        CRACON_LOG_KEYED_ERROR(
+            key.hash(),
+            "The read value %s is not a similar type to %s at %s/%s\n",
+            it->dump().c_str(), typeid(Field).name(), key.str().c_str(),
+            name);
+        return;
+      }
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      value = std::move(converted);
+    });
+  }
+
+  /**
+   * @brief Sets all the fields of a struct declared with CRACON_STRUCT as a
+   * single change.
+   *
+   * @param key The location of the group of fields within the JSON
+   * @param object The struct to store
+   */
+  template <typename T>
+  void store(Key const &key, T const &object) {
+    sets_.fetch_add(1, std::memory_order_relaxed);
+    apply_change(key, [&](JsonT &config) {
+      auto &group = config[key.pointer()];
+      cracon_fields(object, [&](char const *name, auto const &value) {
+        group[name] = value;
+      });
+    });
+  }
+
+  /**
+   * @brief Writes the changed files.
+   *
+   * The configuration is serialized from the current snapshot, thus get() and
+   * set() are not blocked during the write.
+   *
+   * @return true Files are up to date
+   * @return false A file couldn't be written
+   */
+  bool write();
+
+  /**
+   * @brief Writes the changed files as soon as possible.
+   *
+   * With Options::write_behind, the background thread writes the files without
+   * waiting for the debounce. Otherwise, this is a synchronous write().
+   *
+   * @return The result of write() once the files are written.
+   */
+  std::future<bool> flush();
+
+ private:
+  // Writes the content, unless its hash is last_hash, i.e. the file already
+  // contains it. Called with write_mutex_ locked.
+  bool write_to_file(std::string const &filename, std::string const &content,
+                     std::optional<std::uint64_t> &last_hash);
+  // Wakes the write-behind thread up, if any.
+  void notify_change();
+  void start_flusher(std::chrono::milliseconds debounce);
+  void stop_flusher();
+  void flusher_loop(std::chrono::milliseconds debounce);
+  // Maps the blob file of reference if its dtype and size match, fills shape.
+  std::shared_ptr<detail::MappedFile const> open_blob(
+      JsonT const &reference, char const *dtype,
+      std::size_t element_size, std::vector<std::size_t> &shape) const;
+  bool write_blob(Key const &key, std::string const &blob_filename,
+                  char const *dtype, void const *data, std::size_t size,
+                  std::vector<std::size_t> const &shape);
+  // The path of a file relative to the configuration file.
+  std::string relative_path(std::string const &filename) const;
+  // Calls the listeners of the keys changed, given as json pointers.
+  void notify(std::vector<std::string> const &changes);
+  bool start_watcher();
+  void stop_watcher();
+  void watcher_loop(int inotify_fd, std::string const &filename);
+  // Sets the value at key within root.
+  template <typename T>
+  static void assign(JsonT &root, Key const &key, T const &new_value) {
+    auto &val = root[key.pointer()];
+    val = new_value;
+    if (val.is_null()) {
+      CRACON_LOG_KEYED_WARNING(key.hash(), "The key didn't exist for %s\n",
+                               key.str().c_str());
+    } else {
       if (!is_similar<T>(val)) {
-        CRACON_LOG_ERROR(
-            "The read value %s is not a similar type to "
-            "%s at %s defaulted to %s\n",
-            val.dump().c_str(), typeid(T).name(), accessor.c_str(),
-            default_[pointer].dump().c_str());
-        return default_val;
+        CRACON_LOG_KEYED_WARNING(
+            key.hash(),
+            "The new key is not a similar type to the precedent configuration: "
+            "%s replaced by %s\n",
+            key.str().c_str(), val.dump().c_str());
       }
-      return val.get<T>();
-    } catch (std::exception const &ex) {
-      CRACON_LOG_INFO(
+    }
+  }
+  // Converts the value found at key, or returns the default if it is missing
+  // or dissimilar.
+  template <typename T>
+  T convert(JsonT const *val, [[maybe_unused]] Key const &key,
+            T const &default_val) {
+    if (val == nullptr || val->is_null()) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      CRACON_LOG_KEYED_INFO(
+          key.hash(),
           "The requested key doesn't exist for %s defaulted "
-          "to %s. Error: %s\n",
-          accessor.c_str(), default_[pointer].dump().c_str(), ex.what());
-      (void)ex;
+          "to %s\n",
+          key.str().c_str(), JsonT(default_val).dump().c_str());
       return default_val;
     }
+    // This can happen if: The config file is the wrong type or the code is
+    // using the wrong type; It is considered the code is right;
+    T result;
+    if (!try_get(*val, result)) {
+      type_mismatches_.fetch_add(1, std::memory_order_relaxed);
+      CRACON_LOG_KEYED_ERROR(
+          key.hash(),
+          "The read value %s is not a similar type to "
+          "%s at %s defaulted to %s\n",
+          val->dump().c_str(), typeid(T).name(), key.str().c_str(),
+          JsonT(default_val).dump().c_str());
+      return default_val;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return result;
+  }
+  // Locks mutex_ exclusively, recording the time spent waiting for it.
+  std::unique_lock<std::shared_mutex> lock_config();
+  // Locks mutex_ shared and the writers of the module name, recording the time
+  // spent waiting for them.
+  using ModuleLock = std::pair<std::shared_lock<std::shared_mutex>,
+                               std::unique_lock<std::mutex>>;
+  ModuleLock lock_module(std::string const &name);
+  // A change of the configuration at a key, applied to the content of the
+  // configuration file.
+  using Change = std::function<void(JsonT &config)>;
+  // Applies change and publishes it, rethrowing its exception if any. Changes
+  // of different modules are applied in parallel.
+  void apply_change(Key const &key, Change const &change);
+  // Copy of the current snapshot, to be changed then published.
+  std::shared_ptr<Snapshot> next_snapshot() const;
+  // Applies change to next. Only the module of key is copied and, if layered,
+  // merged again, unless key is the root.
+  void apply(Snapshot &next, Key const &key, Change const &change);
+  // The module name of next, to be changed: copied unless next already has its
+  // own copy.
+  typename Snapshot::Module &own(Snapshot &next, std::string const &name);
+  // Replaces the modules of next by those of content, the content of the
+  // configuration file, whose trees are allocated in arena if any.
+  void split(Snapshot &next, JsonT content,
+             std::shared_ptr<Arena> const &arena);
+  // Writes the files of the modules changed, if the configuration is a
+  // directory. Called with write_mutex_ locked.
+  bool write_modules(Snapshot const &current);
+  // Sets the default value at key if it differs from the recorded one.
+  template <typename T>
+  void record_default(Key const &key, T const &default_val) {
+    if (defaults_frozen_) {
+      return;
+    }
+    {
+      std::shared_lock lock(default_mutex_);
+      auto const *recorded = find(default_, key);
+      if (recorded != nullptr && is_equal(*recorded, default_val)) {
+        return;
+      }
+    }
+    std::unique_lock lock(default_mutex_);
+    auto &recorded = default_[key.pointer()];
+    if (!is_equal(recorded, default_val)) {
+      recorded = default_val;
+      should_write_default_ = true;
+      lock.unlock();
+      notify_change();
+    }
   }
 
-  bool write();
+  // Sets the defaults of the fields of object, at once.
+  template <typename T>
+  void record_defaults(Key const &key, T const &object) {
+    if (defaults_frozen_) {
+      return;
+    }
+    {
+      std::shared_lock lock(default_mutex_);
+      auto const *recorded = find(default_, key);
+      bool same = recorded != nullptr && recorded->is_object();
+      cracon_fields(object, [&](char const *name, auto const &value) {
+        if (same) {
+          auto it = recorded->find(name);
+          same = it != recorded->end() && is_equal(*it, value);
+        }
+      });
+      if (same) {
+        return;
+      }
+    }
+    std::unique_lock lock(default_mutex_);
+    auto &recorded = default_[key.pointer()];
+    bool changed = false;
+    cracon_fields(object, [&](char const *name, auto const &value) {
+      auto &field = recorded[name];
+      if (!is_equal(field, value)) {
+        field = value;
+        changed = true;
+      }
+    });
+    if (changed) {
+      should_write_default_ = true;
+      lock.unlock();
+      notify_change();
+    }
+  }
 
- private:
-  // This doesn't lock the mutex as it is an internal function called by the
-  // mutexed function write()
-  bool write_to_file(std::string const &filename, nlohmann::json const &config);
-  nlohmann::json config_ = nlohmann::json::object();
-  nlohmann::json default_ = nlohmann::json::object();
+  // Makes `next` the current snapshot with the next generation number, indexing
+  // its changed modules if enabled. Modules published meanwhile by the writers
+  // of other modules are kept. Called with mutex_ or a module locked.
+  void publish(std::shared_ptr<Snapshot> next);
+  // Replaced, never modified, by writers. Readers atomically load it.
+  std::shared_ptr<Snapshot const> snapshot_ = std::make_shared<Snapshot>();
+  JsonT default_ = JsonT::object();
+  // Merged Options::layers, below the configuration file. Set by init().
+  JsonT base_ = JsonT::object();
   // If data has been changed and this file shall be updated on the next update
   // time.
-  bool should_write_config_ = true;
-  bool should_write_default_ = true;
+  std::atomic<bool> should_write_config_ = true;
+  std::atomic<bool> should_write_default_ = true;
   // Saved for later writing to the file as the file is closed after each usage.
   std::string filename_config_ = "";
   std::string filename_default_ = "";
-  // Prevent multiple write/read to the JSON representation & file.
-  std::mutex mutex_;
+  Options options_;
+  // Taken exclusively by the writers of the whole configuration (init, reload,
+  // transactions and sets of the root), shared by the writers of a module.
+  // Readers and write() never take it.
+  std::shared_mutex mutex_;
+  // Serializes the writers of a module, by the hash of its name: writers of
+  // different modules rarely wait for each other.
+  std::array<std::mutex, 16> module_mutexes_;
+  // Orders the modules created, see Snapshot::Module::order.
+  std::atomic<std::uint64_t> module_order_ = 0;
+  // Serializes the writes to the files.
+  std::mutex write_mutex_;
+  // Hash of the content of the files, as last read or written.
+  std::optional<std::uint64_t> config_hash_;
+  // If the configuration is a directory of modules, their hashes by name.
+  bool directory_ = false;
+  std::map<std::string, std::optional<std::uint64_t>> module_hashes_;
+  // Modules to write, with the generation of their last change.
+  std::map<std::string, std::uint64_t> dirty_modules_;
+  std::mutex modules_mutex_;
+  std::optional<std::uint64_t> default_hash_;
+  // Incremented by the readers, on their own cache line.
+  alignas(64) std::atomic<std::uint64_t> hits_ = 0;
+  std::atomic<std::uint64_t> misses_ = 0;
+  std::atomic<std::uint64_t> type_mismatches_ = 0;
+  alignas(64) std::atomic<std::uint64_t> sets_ = 0;
+  std::atomic<std::uint64_t> writes_ = 0;
+  std::atomic<std::uint64_t> skipped_writes_ = 0;
+  std::atomic<std::uint64_t> bytes_written_ = 0;
+  detail::AtomicHistogram write_latency_;
+  detail::AtomicHistogram lock_wait_;
+  // Protects the defaults, which are recorded by get(). Only taken exclusively
+  // when a default changes.
+  std::shared_mutex default_mutex_;
+  std::atomic<bool> defaults_frozen_ = false;
+  // Write-behind thread, running if Options::write_behind.
+  std::thread flusher_;
+  std::mutex flusher_mutex_;
+  std::condition_variable flusher_cv_;
+  bool flusher_running_ = false;
+  bool flusher_stop_ = false;
+  bool flusher_dirty_ = false;
+  std::vector<std::promise<bool>> flush_promises_;
+  // Subscriptions by key. Ordered to find the children of a key. Shared with
+  // the subscriptions, which remove themselves once released.
+  struct Listeners {
+    std::map<std::string, std::vector<std::weak_ptr<Listener>>> by_key;
+    std::mutex mutex;
+  };
+  std::shared_ptr<Listeners> listeners_ = std::make_shared<Listeners>();
+  // Thread reloading the configuration if Options::watch.
+  std::thread watcher_;
+  std::atomic<bool> watching_ = false;
+  int watcher_stop_fd_ = -1;
 };
 
 /**
@@ -140,17 +879,21 @@ class File {
  * classes.
  *
  */
-class SharedFile {
+template <typename JsonT>
+class basic_SharedFile {
  public:
-  SharedFile(){};
-  SharedFile(std::string const &filename_config,
-             std::string const &filename_default);
+  using File = basic_File<JsonT>;
+
+  basic_SharedFile(){};
+  basic_SharedFile(std::string const &filename_config,
+                   std::string const &filename_default,
+                   Options const &options = {});
   /**
    * @brief Sets the configuration filenames and parses them if it exists. See
    * `File::init`
    */
   bool init(std::string const &filename_config,
-            std::string const &filename_default);
+            std::string const &filename_default, Options const &options = {});
 
   /**
    * Live parameter directly writing to/from the file.
@@ -166,10 +909,16 @@ class SharedFile {
      * The aim of this structure is to reduce the risk of typos in param_name
      * between get and set functions.
      */
-    Param(std::shared_ptr<File> config, std::string const &param_name,
-          Type default_value)
-        : config_(config), accessor_(param_name), default_(default_value) {
-      data_ = config_->get<Type>(accessor_, default_value);
+    Param(std::shared_ptr<File> config, Key const &key, Type default_value)
+        : config_(config), key_(key), default_(default_value) {
+      data_ = config_->template get<Type>(key_, default_value);
+      changes_ = std::make_shared<std::atomic<std::uint64_t>>(0);
+      // Params are often temporaries, they only subscribe if a watcher
+      // reloads the configuration behind their back.
+      if (config_->watching()) {
+        subscription_ = config_->subscribe(
+            key_, [changes = changes_] { changes->fetch_add(1); });
+      }
     };
 
     /**
@@ -182,12 +931,14 @@ class SharedFile {
     };
 
     /**
-     * @brief Fetches a copy of the current data. This doesn't touch the file.
+     * @brief Fetches a copy of the current data. This only reads the file if a
+     * reload of the watched file, see Options::watch, changed the value.
      *
      * @return Type data
      */
     Type get() {
       assert(config_ != nullptr);
+      refresh();
       return data_;
     }
 
@@ -200,6 +951,7 @@ class SharedFile {
      */
     Type &get_ref() {
       assert(config_ != nullptr);
+      refresh();
       return data_;
     }
 
@@ -212,6 +964,7 @@ class SharedFile {
      */
     Type *get_ptr() {
       assert(config_ != nullptr);
+      refresh();
       return &data_;
     }
 
@@ -220,7 +973,7 @@ class SharedFile {
      */
     void set(Type data) {
       assert(config_ != nullptr);
-      data_ = config_->set<Type>(accessor_, data);
+      data_ = config_->template set<Type>(key_, data);
     }
 
     /**
@@ -229,7 +982,7 @@ class SharedFile {
      */
     void update() {
       assert(config_ != nullptr);
-      (void)config_->set<Type>(accessor_, data_);
+      (void)config_->template set<Type>(key_, data_);
     }
 
     /**
@@ -239,10 +992,95 @@ class SharedFile {
     void reset() { set(default_); }
 
    private:
+    // Reads the value again if a reload changed it.
+    void refresh() {
+      if (changes_ == nullptr) {
+        return;  // Default constructed
+      }
+      auto const changes = changes_->load(std::memory_order_relaxed);
+      if (changes != seen_changes_) {
+        seen_changes_ = changes;
+        data_ = config_->template get<Type>(key_, default_);
+      }
+    }
+
     Type data_;
     Type default_;
     std::shared_ptr<File> config_ = nullptr;
-    std::string accessor_;
+    Key key_;
+    // Incremented by the subscription when a reload changes the value. Copies
+    // of the Param share it, thus each keeps track of the changes it has seen.
+    std::shared_ptr<std::atomic<std::uint64_t>> changes_;
+    std::uint64_t seen_changes_ = 0;
+    std::shared_ptr<typename File::Listener> subscription_;
+  };
+
+  /**
+   * Parameter safe to read from a realtime thread.
+   *
+   * Reads never lock, never allocate and never see a torn value, even while
+   * another thread sets it or the configuration is reloaded. Restricted to
+   * trivially copyable types: numbers, enums, std::array of those.
+   *
+   * Copies share the value.
+   */
+  template <typename Type>
+  class RealtimeParam {
+   public:
+    RealtimeParam(std::shared_ptr<File> config, Key const &key,
+                  Type default_value)
+        : config_(config), key_(key), default_(default_value) {
+      state_ = std::make_shared<State>();
+      state_->value.store(config_->template get<Type>(key_, default_));
+      std::weak_ptr<State> weak_state = state_;
+      File *file = config_.get();
+      subscription_ = config_->subscribe(
+          key_, [weak_state, file, key = key_, default_value] {
+            if (auto state = weak_state.lock()) {
+              std::unique_lock lock(state->write_mutex);
+              state->value.store(file->template get<Type>(key, default_value));
+            }
+          });
+    }
+
+    RealtimeParam() = default;
+
+    /**
+     * @brief Copies the current data. Wait-free unless a write is in progress,
+     * in which case the copy is retried.
+     */
+    Type get() const {
+      assert(state_ != nullptr);
+      return state_->value.load();
+    }
+
+    /**
+     * @brief Changes the data here and in the configuration. This locks the
+     * File, do not call it from a realtime thread.
+     */
+    void set(Type data) {
+      assert(config_ != nullptr);
+      std::unique_lock lock(state_->write_mutex);
+      state_->value.store(config_->template set<Type>(key_, data));
+    }
+
+    /**
+     * @brief Sets the default value
+     */
+    void reset() { set(default_); }
+
+   private:
+    struct State {
+      Seqlock<Type> value;
+      // Serializes set() and the reloads.
+      std::mutex write_mutex;
+    };
+
+    std::shared_ptr<File> config_ = nullptr;
+    Key key_;
+    Type default_{};
+    std::shared_ptr<State> state_;
+    std::shared_ptr<typename File::Listener> subscription_;
   };
 
   /**
@@ -251,33 +1089,63 @@ class SharedFile {
   class Group {
    public:
     Group(std::shared_ptr<File> config, std::string const &config_name)
-        : config_(config), namespace_(config_name){};
+        : config_(config), prefix_("/" + config_name){};
 
     [[nodiscard]] Group get_group(std::string const &config_name) {
-      return Group(config_, namespace_ + "/" + config_name);
+      Group group = *this;
+      group.prefix_ = prefix_ / config_name;
+      return group;
+    }
+    /**
+     * @brief Precompiles the key of a parameter of this group.
+     *
+     * Store the result to access the parameter repeatedly through File::get or
+     * File::set without parsing the accessor again.
+     */
+    [[nodiscard]] Key key(std::string const &accessor) const {
+      return prefix_ / accessor;
     }
     template <typename T>
     [[nodiscard]] auto set(std::string const &accessor, T const &new_value)
         -> T {
-      std::string pointer = "/" + namespace_ + "/" + accessor;
-      return config_->set(pointer, new_value);
+      return config_->set(key(accessor), new_value);
     }
     template <typename T>
     [[nodiscard]] auto get(std::string const &accessor, T const &default_val)
         -> T {
-      std::string pointer = "/" + namespace_ + "/" + accessor;
-      return config_->get(pointer, default_val);
+      return config_->get(key(accessor), default_val);
     }
     template <typename Type>
     [[nodiscard]] auto get_param(std::string const &param_name,
                                  Type const &default_val) -> Param<Type> {
-      std::string pointer = "/" + namespace_ + "/" + param_name;
-      return Param<Type>(config_, pointer, default_val);
+      return Param<Type>(config_, key(param_name), default_val);
+    }
+    /**
+     * @brief Loads a struct declared with CRACON_STRUCT from this group, see
+     * File::bind.
+     */
+    template <typename T>
+    void bind(T &object) {
+      config_->bind(prefix_, object);
+    }
+    /**
+     * @brief Stores a struct declared with CRACON_STRUCT in this group, see
+     * File::store.
+     */
+    template <typename T>
+    void store(T const &object) {
+      config_->store(prefix_, object);
+    }
+    template <typename Type>
+    [[nodiscard]] auto get_realtime_param(std::string const &param_name,
+                                          Type const &default_val)
+        -> RealtimeParam<Type> {
+      return RealtimeParam<Type>(config_, key(param_name), default_val);
     }
 
    private:
     std::shared_ptr<File> config_;
-    std::string namespace_;
+    Key prefix_;
   };
 
   /**
@@ -298,38 +1166,97 @@ class SharedFile {
    * This prevents typos.
    *
    * @tparam Type
-   * @param param_name
+   * @param key
    * @param default_val
    * @return Param<Type>
    */
   template <typename Type>
-  Param<Type> get_param(std::string const &param_name,
-                        Type const &default_val) {
-    return Param<Type>(file_, param_name, default_val);
+  Param<Type> get_param(Key const &key, Type const &default_val) {
+    return Param<Type>(file_, key, default_val);
+  }
+
+  /**
+   * @brief Returns a parameter safe to read from a realtime thread, see
+   * RealtimeParam.
+   */
+  template <typename Type>
+  RealtimeParam<Type> get_realtime_param(Key const &key,
+                                         Type const &default_val) {
+    return RealtimeParam<Type>(file_, key, default_val);
   }
 
   // Same as File::get()
   template <typename T>
-  [[nodiscard]] auto get(std::string const &accessor, T const &default_val)
-      -> T {
-    return file_->get<T>(accessor, default_val);
+  [[nodiscard]] auto get(Key const &key, T const &default_val) -> T {
+    return file_->template get<T>(key, default_val);
   }
 
   // Same as File::set()
   template <typename T>
-  [[nodiscard]] auto set(std::string const &accessor, T const &new_value) -> T {
-    return file_->set(accessor, new_value);
+  [[nodiscard]] auto set(Key const &key, T const &new_value) -> T {
+    return file_->set(key, new_value);
+  }
+
+  // Same as File::get_view()
+  template <typename T>
+  [[nodiscard]] typename File::template View<T> get_view(Key const &key) const {
+    return file_->template get_view<T>(key);
+  }
+
+  // Same as File::get_blob()
+  template <typename T>
+  [[nodiscard]] Blob<T> get_blob(Key const &key) const {
+    return file_->template get_blob<T>(key);
+  }
+
+  // Same as File::set_blob()
+  template <typename T>
+  bool set_blob(Key const &key, std::string const &blob_filename,
+                std::vector<T> const &data,
+                std::vector<std::size_t> shape = {}) {
+    return file_->set_blob(key, blob_filename, data, std::move(shape));
+  }
+
+  // Same as File::bind()
+  template <typename T>
+  void bind(Key const &key, T &object) {
+    file_->bind(key, object);
+  }
+
+  // Same as File::store()
+  template <typename T>
+  void store(Key const &key, T const &object) {
+    file_->store(key, object);
+  }
+
+  // Same as File::transaction()
+  [[nodiscard]] typename File::Transaction transaction() {
+    return file_->transaction();
   }
 
   // Same as File::should_write()
   bool should_write();
   // Same as File::write()
   bool write();
+  // Same as File::flush()
+  std::future<bool> flush();
 
  private:
   std::shared_ptr<File> file_ = std::make_shared<File>();
 };
 
+using File = basic_File<nlohmann::json>;
+using SharedFile = basic_SharedFile<nlohmann::json>;
+
+// Instantiated by the library. Include cracon/cracon_impl.hpp to use another
+// JSON type.
+extern template class basic_File<nlohmann::json>;
+extern template class basic_File<nlohmann::ordered_json>;
+extern template class basic_File<ArenaJson>;
+extern template class basic_SharedFile<nlohmann::json>;
+extern template class basic_SharedFile<nlohmann::ordered_json>;
+extern template class basic_SharedFile<ArenaJson>;
+
 std::string get_package_share_directory(const std::string &package_name);
 }  // namespace cracon
 
@@ -0,0 +1,1235 @@
+#ifndef CRACON_CRACON_IMPL_HPP
+#define CRACON_CRACON_IMPL_HPP
+
+// Definitions of basic_File and basic_SharedFile. The library instantiates
+// them for nlohmann::json, nlohmann::ordered_json and ArenaJson; include this
+// header in one source file to instantiate them for another JSON type:
+//
+//   #include <cracon/cracon_impl.hpp>
+//   template class cracon::basic_File<MyJson>;
+//   template class cracon::basic_SharedFile<MyJson>;
+
+#include <algorithm>
+#include <cassert>
+#include <cracon/cracon.hpp>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace cracon {
+
+namespace detail {
+// Reads the whole file in a single contiguous buffer, false if it can't be
+// opened.
+bool read_file(std::string const &filename, std::string &content,
+               std::ios::openmode mode = std::ios::in);
+
+std::string sidecar_filename(std::string const &filename, Sidecar sidecar);
+
+// The file of the module name within the configuration directory.
+std::string module_filename(std::string const &directory,
+                            std::string const &name);
+
+// Throws std::invalid_argument if the module can't be a file name.
+void check_module_name(std::string const &name);
+
+// The arena of the trees parsed for a snapshot, if JsonT allocates in arenas.
+template <typename JsonT>
+std::shared_ptr<Arena> make_arena() {
+  if constexpr (std::is_same_v<typename JsonT::allocator_type,
+                               ArenaAllocator<JsonT>>) {
+    return std::make_shared<Arena>();
+  } else {
+    return nullptr;
+  }
+}
+
+// Identifies the content of the JSON file the sidecar was generated from.
+template <typename JsonT>
+JsonT source_info(std::string const &filename, std::uint64_t hash) {
+  return {
+      {"size", std::filesystem::file_size(filename)},
+      {"mtime", std::filesystem::last_write_time(filename)
+                    .time_since_epoch()
+                    .count()},
+      {"hash", hash},
+  };
+}
+
+// Loads the sidecar of filename in config, if it is up to date.
+template <typename JsonT>
+bool load_sidecar(std::string const &filename, Sidecar sidecar,
+                  std::uint64_t hash, JsonT &config) {
+  try {
+    std::string content;
+    if (!read_file(sidecar_filename(filename, sidecar), content,
+                   std::ios::in | std::ios::binary)) {
+      return false;
+    }
+    auto document = sidecar == Sidecar::cbor
+                        ? JsonT::from_cbor(content, true, false)
+                        : JsonT::from_msgpack(content, true, false);
+    if (document.is_discarded() || !document.contains("config") ||
+        document["source"] != source_info<JsonT>(filename, hash)) {
+      return false;
+    }
+    config = std::move(document["config"]);
+    return true;
+  } catch (std::exception const &ex) {
+    CRACON_LOG_WARNING("Ignoring the sidecar of %s: %s\n", filename.c_str(),
+                       ex.what());
+    (void)ex;
+    return false;
+  }
+}
+
+template <typename JsonT>
+void store_sidecar(std::string const &filename, Sidecar sidecar,
+                   std::uint64_t hash, JsonT const &config) {
+  try {
+    JsonT const document = {
+        {"source", source_info<JsonT>(filename, hash)},
+        {"config", config},
+    };
+    auto const content = sidecar == Sidecar::cbor
+                             ? JsonT::to_cbor(document)
+                             : JsonT::to_msgpack(document);
+    std::ofstream output_file(sidecar_filename(filename, sidecar),
+                              std::ios::out | std::ios::binary);
+    output_file.write(reinterpret_cast<char const *>(content.data()),
+                      static_cast<std::streamsize>(content.size()));
+  } catch (std::exception const &ex) {
+    CRACON_LOG_WARNING("Couldn't write the sidecar of %s: %s\n",
+                       filename.c_str(), ex.what());
+    (void)ex;
+  }
+}
+
+// Appends the reference token of name to path, i.e. "/a~1b" for "a/b".
+inline void append_token(std::string &path, std::string const &name) {
+  path += '/';
+  for (char c : name) {
+    if (c == '~') {
+      path += "~0";
+    } else if (c == '/') {
+      path += "~1";
+    } else {
+      path += c;
+    }
+  }
+}
+
+// Adds value and its children to the index, `path` being the key of value.
+template <typename JsonT, typename Index>
+void index_values(JsonT const &value, std::string &path, Index &index) {
+  index.try_emplace(fnv1a(path), typename Index::mapped_type{path, &value});
+  auto const size = path.size();
+  if (value.is_object()) {
+    for (auto const &item : value.items()) {
+      append_token(path, item.key());
+      index_values(item.value(), path, index);
+      path.resize(size);
+    }
+  } else if (value.is_array()) {
+    for (std::size_t i = 0; i < value.size(); i++) {
+      path += '/';
+      path += std::to_string(i);
+      index_values(value[i], path, index);
+      path.resize(size);
+    }
+  }
+}
+
+// Indexes the values of the module named name.
+template <typename Module>
+void index_module(std::string const &name, Module &module) {
+  module.index.clear();
+  if (module.value) {
+    std::string path;
+    append_token(path, name);
+    index_values(*module.value, path, module.index);
+  }
+  module.indexed = true;
+}
+
+// Reads the *.json files of directory in config, each one being the module
+// named after the file, i.e. car.json is /car. Files are parsed on a few
+// threads, allocating in arena if any. Returns the hash of each file, throws
+// the first parse error.
+template <typename JsonT>
+std::map<std::string, std::optional<std::uint64_t>> read_modules(
+    std::string const &directory, Sidecar sidecar, JsonT &config,
+    Arena *arena) {
+  struct Module {
+    std::string name;
+    std::uint64_t hash = 0;
+    JsonT value = nullptr;
+    std::exception_ptr error = nullptr;
+  };
+  std::vector<Module> modules;
+  std::error_code error;
+  for (auto const &entry :
+       std::filesystem::directory_iterator(directory, error)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".json") {
+      modules.push_back({entry.path().stem().string()});
+    }
+  }
+  std::atomic<std::size_t> next_module = 0;
+  auto parse_modules = [&] {
+    for (auto i = next_module++; i < modules.size(); i = next_module++) {
+      auto &module = modules[i];
+      auto const filename = module_filename(directory, module.name);
+      std::optional<ArenaScope> scope;
+      if (arena != nullptr) {
+        scope.emplace(*arena);
+      }
+      try {
+        std::string content;
+        if (!read_file(filename, content)) {
+          throw std::runtime_error("Couldn't read " + filename);
+        }
+        module.hash = fnv1a(content);
+        if (sidecar == Sidecar::none ||
+            !load_sidecar(filename, sidecar, module.hash, module.value)) {
+          module.value = JsonT::parse(
+              content.data(), content.data() + content.size());
+          if (sidecar != Sidecar::none) {
+            store_sidecar(filename, sidecar, module.hash, module.value);
+          }
+        }
+      } catch (...) {
+        module.error = std::current_exception();
+      }
+    }
+  };
+  constexpr std::size_t kMaxThreads = 8;
+  auto const threads = std::min(
+      {modules.size(), kMaxThreads,
+       std::max<std::size_t>(1, std::thread::hardware_concurrency())});
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < threads; i++) {
+    workers.emplace_back(parse_modules);
+  }
+  parse_modules();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  std::map<std::string, std::optional<std::uint64_t>> hashes;
+  for (auto &module : modules) {
+    if (module.error) {
+      std::rethrow_exception(module.error);
+    }
+    hashes[module.name] = module.hash;
+    config[module.name] = std::move(module.value);
+  }
+  return hashes;
+}
+}  // namespace detail
+
+template <typename JsonT>
+basic_File<JsonT>::basic_File(std::string const &filename_config,
+                              std::string const &filename_default,
+                              Options const &options) {
+  init(filename_config, filename_default, options);
+}
+
+template <typename JsonT>
+basic_File<JsonT>::~basic_File() {
+  stop_watcher();
+  if (flusher_.joinable()) {
+    stop_flusher();
+    write();
+  }
+}
+
+template <typename JsonT>
+JsonT const &basic_File<JsonT>::Snapshot::assemble(
+    std::shared_ptr<JsonT const> &cache, bool file) const {
+  if (auto const assembled = std::atomic_load(&cache)) {
+    return *assembled;
+  }
+  std::vector<std::pair<std::string const *, Module const *>> ordered;
+  for (auto const &module : modules) {
+    ordered.emplace_back(&module.first, module.second.get());
+  }
+  std::sort(ordered.begin(), ordered.end(), [](auto const &a, auto const &b) {
+    return a.second->order < b.second->order;
+  });
+  auto assembled = std::make_shared<JsonT>(JsonT::object());
+  for (auto const &[name, module] : ordered) {
+    auto const &value = file ? module->layer : module->value;
+    if (value) {
+      (*assembled)[*name] = *value;
+    }
+  }
+  // Readers may assemble it at the same time, the first one is kept.
+  std::shared_ptr<JsonT const> expected;
+  std::shared_ptr<JsonT const> desired = std::move(assembled);
+  if (!std::atomic_compare_exchange_strong(&cache, &expected, desired)) {
+    return *expected;
+  }
+  return *desired;
+}
+
+template <typename JsonT>
+bool basic_File<JsonT>::write() {
+  auto const start = std::chrono::steady_clock::now();
+  std::unique_lock lock(write_mutex_);
+  // Flags are cleared before serializing; changes made during the write set
+  // them again.
+  if (should_write_config_.exchange(false)) {
+    auto const current = snapshot();
+    auto const previous_hash = config_hash_;
+    if (directory_) {
+      if (!write_modules(*current)) {
+        should_write_config_ = true;
+      }
+    } else if (!write_to_file(filename_config_,
+                              current->file_content().dump(4), config_hash_)) {
+      should_write_config_ = true;
+    } else if (options_.sidecar != Sidecar::none &&
+               config_hash_ != previous_hash) {
+      detail::store_sidecar(filename_config_, options_.sidecar, *config_hash_,
+                            current->file_content());
+    }
+  }
+  if (should_write_default_.exchange(false)) {
+    std::string content;
+    {
+      std::shared_lock default_lock(default_mutex_);
+      content = default_.dump(4);
+    }
+    if (!write_to_file(filename_default_, content, default_hash_)) {
+      should_write_default_ = true;
+    }
+  }
+
+  write_latency_.record(std::chrono::steady_clock::now() - start);
+  return !should_write();
+}
+
+template <typename JsonT>
+bool basic_File<JsonT>::write_modules(Snapshot const &current) {
+  // The modules changed up to the current generation, later changes are
+  // written by the next write.
+  std::vector<std::string> names;
+  {
+    std::unique_lock lock(modules_mutex_);
+    for (auto it = dirty_modules_.begin(); it != dirty_modules_.end();) {
+      if (it->second <= current.generation) {
+        names.push_back(it->first);
+        it = dirty_modules_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  if (!names.empty() && names.front().empty()) {
+    // The root changed, all the modules are compared.
+    names.clear();
+    for (auto const &module : current.modules) {
+      names.push_back(module.first);
+    }
+    for (auto const &module : module_hashes_) {
+      names.push_back(module.first);
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(filename_config_, error);
+  bool success = true;
+  for (auto const &name : names) {
+    if (name.find('/') != std::string::npos) {
+      // Rejected by set(), kept dirty rather than lost if it gets here.
+      CRACON_LOG_ERROR("The module %s can't be a file\n", name.c_str());
+      std::unique_lock lock(modules_mutex_);
+      dirty_modules_.emplace(name, current.generation);
+      success = false;
+      continue;
+    }
+    auto const filename = detail::module_filename(filename_config_, name);
+    auto const it = current.modules.find(name);
+    JsonT const *module = nullptr;
+    if (it != current.modules.end()) {
+      auto const &value = current.layered ? it->second->layer
+                                          : it->second->value;
+      module = value ? &*value : nullptr;
+    }
+    if (module == nullptr) {
+      // Removed from the configuration.
+      if (module_hashes_.erase(name) > 0) {
+        std::filesystem::remove(filename, error);
+      }
+      continue;
+    }
+    auto const previous_hash = module_hashes_[name];
+    bool written = write_to_file(filename, module->dump(4),
+                                 module_hashes_[name]);
+    if (written && options_.sidecar != Sidecar::none &&
+        module_hashes_[name] != previous_hash) {
+      detail::store_sidecar(filename, options_.sidecar, *module_hashes_[name],
+                            *module);
+    }
+    if (!written) {
+      std::unique_lock lock(modules_mutex_);
+      dirty_modules_.emplace(name, current.generation);
+      success = false;
+    }
+  }
+  return success;
+}
+
+template <typename JsonT>
+std::future<bool> basic_File<JsonT>::flush() {
+  std::promise<bool> promise;
+  auto result = promise.get_future();
+  {
+    std::unique_lock lock(flusher_mutex_);
+    if (flusher_running_) {
+      flush_promises_.push_back(std::move(promise));
+      flusher_cv_.notify_one();
+      return result;
+    }
+  }
+  promise.set_value(write());
+  return result;
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::notify_change() {
+  std::unique_lock lock(flusher_mutex_);
+  if (flusher_running_) {
+    flusher_dirty_ = true;
+    flusher_cv_.notify_one();
+  }
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::start_flusher(std::chrono::milliseconds debounce) {
+  std::unique_lock lock(flusher_mutex_);
+  flusher_running_ = true;
+  flusher_stop_ = false;
+  flusher_dirty_ = false;
+  flusher_ = std::thread(&basic_File::flusher_loop, this, debounce);
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::stop_flusher() {
+  {
+    std::unique_lock lock(flusher_mutex_);
+    if (!flusher_running_) {
+      return;
+    }
+    flusher_running_ = false;
+    flusher_stop_ = true;
+    flusher_cv_.notify_one();
+  }
+  flusher_.join();
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::flusher_loop(std::chrono::milliseconds debounce) {
+  std::unique_lock lock(flusher_mutex_);
+  while (true) {
+    flusher_cv_.wait(lock, [this] {
+      return flusher_stop_ || flusher_dirty_ || !flush_promises_.empty();
+    });
+    if (flusher_stop_ && flush_promises_.empty()) {
+      break;
+    }
+    // Coalesce the changes made within the debounce window, unless someone
+    // waits for the write.
+    flusher_cv_.wait_for(lock, debounce, [this] {
+      return flusher_stop_ || !flush_promises_.empty();
+    });
+    flusher_dirty_ = false;
+    auto promises = std::move(flush_promises_);
+    flush_promises_.clear();
+    lock.unlock();
+    bool const result = write();
+    for (auto &promise : promises) {
+      promise.set_value(result);
+    }
+    lock.lock();
+  }
+}
+
+template <typename JsonT>
+bool basic_File<JsonT>::write_to_file(std::string const &filename,
+                                      std::string const &content,
+                                      std::optional<std::uint64_t> &last_hash) {
+  try {
+    if (filename.empty()) {
+      CRACON_LOG_ERROR("The filename is not set, did you init?\n");
+      assert(false);
+      return false;
+    }
+    // The file is terminated by a new line
+    auto const hash = detail::fnv1a("\n", detail::fnv1a(content));
+    if (last_hash == hash) {
+      skipped_writes_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    last_hash.reset();
+    std::ofstream output_file(filename);
+    output_file << content << std::endl;
+    output_file.close();
+    if (!output_file) {
+      CRACON_LOG_ERROR("Error writing the file %s\n", filename.c_str());
+      return false;
+    }
+    last_hash = hash;
+    writes_.fetch_add(1, std::memory_order_relaxed);
+    bytes_written_.fetch_add(content.size() + 1, std::memory_order_relaxed);
+    return true;
+  } catch (std::exception const &ex) {
+    CRACON_LOG_ERROR("Error writing the file %s: %s\n", filename.c_str(),
+                     ex.what());
+    (void)ex;
+    return false;
+  }
+}
+
+template <typename JsonT>
+bool basic_File<JsonT>::init(std::string const &filename_config,
+                             std::string const &filename_default,
+                             Options const &options) {
+  stop_watcher();
+  stop_flusher();
+  {
+    auto lock = lock_config();
+    std::unique_lock write_lock(write_mutex_);
+    filename_config_ = filename_config;
+    filename_default_ = filename_default;
+    options_ = options;
+    base_ = JsonT::object();
+    for (auto const &layer : options.layers) {
+      std::string content;
+      if (!detail::read_file(layer, content)) {
+        CRACON_LOG_INFO("The layer %s doesn't exist, skipped\n", layer.c_str());
+        continue;
+      }
+      base_.merge_patch(
+          JsonT::parse(content.data(), content.data() + content.size()));
+    }
+    auto const arena = detail::make_arena<JsonT>();
+    auto config = JsonT::object();
+    std::string content;
+    config_hash_.reset();
+    directory_ = std::filesystem::is_directory(filename_config) ||
+                 (!filename_config.empty() && filename_config.back() == '/');
+    module_hashes_.clear();
+    {
+      std::unique_lock modules_lock(modules_mutex_);
+      dirty_modules_.clear();
+    }
+    std::optional<ArenaScope> scope;
+    if (arena != nullptr) {
+      scope.emplace(*arena);
+    }
+    if (directory_) {
+      module_hashes_ = detail::read_modules(filename_config, options.sidecar,
+                                            config, arena.get());
+    } else if (detail::read_file(filename_config, content)) {
+      config_hash_ = detail::fnv1a(content);
+      if (options.sidecar == Sidecar::none ||
+          !detail::load_sidecar(filename_config, options.sidecar,
+                                *config_hash_, config)) {
+        // Parsing from a contiguous range avoids the stream adapter overhead.
+        config = JsonT::parse(content.data(), content.data() + content.size());
+        if (options.sidecar != Sidecar::none) {
+          detail::store_sidecar(filename_config, options.sidecar,
+                                *config_hash_, config);
+        }
+      }
+      if (config.is_null()) {
+        config = JsonT::object();
+      }
+    }
+    scope.reset();
+    auto next = std::make_shared<Snapshot>();
+    split(*next, std::move(config), arena);
+    default_hash_.reset();
+    if (detail::read_file(filename_default, content)) {
+      default_hash_ = detail::fnv1a(content);
+    }
+    // Only missing files need to be created right away.
+    should_write_config_ = directory_
+                               ? !std::filesystem::exists(filename_config)
+                               : !config_hash_;
+    should_write_default_ = !default_hash_;
+    publish(std::move(next));
+  }
+  if (options.write_behind) {
+    start_flusher(options.write_behind_debounce);
+  }
+  bool const written = write();
+  if (options.watch && !start_watcher()) {
+    return false;
+  }
+  return written;
+}
+
+template <typename JsonT>
+bool basic_File<JsonT>::reload() {
+  std::vector<std::string> changes;
+  {
+    auto lock = lock_config();
+    std::unique_lock write_lock(write_mutex_);
+    std::string content;
+    std::uint64_t hash = 0;
+    auto const arena = detail::make_arena<JsonT>();
+    auto config = JsonT::object();
+    std::optional<ArenaScope> scope;
+    if (arena != nullptr) {
+      scope.emplace(*arena);
+    }
+    try {
+      if (directory_) {
+        auto hashes = detail::read_modules(filename_config_, options_.sidecar,
+                                           config, arena.get());
+        if (hashes == module_hashes_) {
+          // Unchanged or written by us.
+          return true;
+        }
+        module_hashes_ = std::move(hashes);
+      } else {
+        if (!detail::read_file(filename_config_, content)) {
+          return false;
+        }
+        hash = detail::fnv1a(content);
+        if (config_hash_ == hash) {
+          // Unchanged or written by us.
+          return true;
+        }
+        config = JsonT::parse(content.data(), content.data() + content.size());
+      }
+      scope.reset();
+    } catch (std::exception const &ex) {
+      // i.e. The file is being written, it will be reloaded once complete.
+      CRACON_LOG_WARNING("Couldn't reload %s: %s\n", filename_config_.c_str(),
+                         ex.what());
+      (void)ex;
+      return false;
+    }
+    if (config.is_null()) {
+      config = JsonT::object();
+    }
+    if (!directory_) {
+      if (options_.sidecar != Sidecar::none) {
+        detail::store_sidecar(filename_config_, options_.sidecar, hash, config);
+      }
+      config_hash_ = hash;
+    }
+    auto next = std::make_shared<Snapshot>();
+    split(*next, std::move(config), arena);
+    for (auto const &operation :
+         JsonT::diff(snapshot()->config(), next->config())) {
+      changes.push_back(operation["path"].template get<std::string>());
+    }
+    should_write_config_ = false;
+    publish(std::move(next));
+  }
+  notify(changes);
+  return true;
+}
+
+template <typename JsonT>
+std::shared_ptr<typename basic_File<JsonT>::Listener>
+basic_File<JsonT>::subscribe(Key const &key, Listener listener) {
+  auto prune = [](auto &subscriptions) {
+    subscriptions.erase(
+        std::remove_if(subscriptions.begin(), subscriptions.end(),
+                       [](auto const &weak) { return weak.expired(); }),
+        subscriptions.end());
+  };
+  // Removes the entry once the last handle is released, the file may be gone.
+  std::weak_ptr<Listeners> weak_listeners = listeners_;
+  std::shared_ptr<Listener> subscription(
+      new Listener(std::move(listener)),
+      [weak_listeners, prune, path = key.str()](Listener *released) {
+        delete released;
+        if (auto listeners = weak_listeners.lock()) {
+          std::unique_lock lock(listeners->mutex);
+          auto it = listeners->by_key.find(path);
+          if (it != listeners->by_key.end()) {
+            prune(it->second);
+            if (it->second.empty()) {
+              listeners->by_key.erase(it);
+            }
+          }
+        }
+      });
+  std::unique_lock lock(listeners_->mutex);
+  auto &subscriptions = listeners_->by_key[key.str()];
+  prune(subscriptions);
+  subscriptions.push_back(subscription);
+  return subscription;
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::notify(std::vector<std::string> const &changes) {
+  std::vector<std::shared_ptr<Listener>> notified;
+  {
+    std::unique_lock lock(listeners_->mutex);
+    auto collect = [&](auto it) {
+      auto &subscriptions = it->second;
+      for (auto subscription = subscriptions.begin();
+           subscription != subscriptions.end();) {
+        if (auto listener = subscription->lock()) {
+          notified.push_back(std::move(listener));
+          ++subscription;
+        } else {
+          subscription = subscriptions.erase(subscription);
+        }
+      }
+    };
+    for (auto const &path : changes) {
+      // The changed key and its parents, i.e. "/a/b" and "/a" for "/a/b"
+      for (auto end = path.size(); end != std::string::npos;
+           end = end == 0 ? std::string::npos : path.rfind('/', end - 1)) {
+        auto it = listeners_->by_key.find(path.substr(0, end));
+        if (it != listeners_->by_key.end()) {
+          collect(it);
+        }
+      }
+      // Its children, i.e. "/a/b/c". '0' follows '/' in ASCII.
+      auto const last = listeners_->by_key.lower_bound(path + "0");
+      for (auto it = listeners_->by_key.lower_bound(path + "/"); it != last;
+           ++it) {
+        collect(it);
+      }
+    }
+  }
+  // A listener is called once, even if multiple of its keys changed.
+  std::sort(notified.begin(), notified.end());
+  notified.erase(std::unique(notified.begin(), notified.end()),
+                 notified.end());
+  for (auto const &listener : notified) {
+    (*listener)();
+  }
+}
+
+template <typename JsonT>
+bool basic_File<JsonT>::start_watcher() {
+#ifdef __linux__
+  std::unique_lock lock(write_mutex_);
+  // Editors often replace the file, thus the folder is watched.
+  auto path = std::filesystem::absolute(filename_config_);
+  if (directory_) {
+    // Any module, see watcher_loop.
+    path /= "";
+  }
+  int inotify_fd = inotify_init1(IN_CLOEXEC);
+  if (inotify_fd < 0) {
+    CRACON_LOG_ERROR("Couldn't initialize inotify\n");
+    return false;
+  }
+  if (inotify_add_watch(inotify_fd, path.parent_path().c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    CRACON_LOG_ERROR("Couldn't watch %s\n", path.parent_path().c_str());
+    close(inotify_fd);
+    return false;
+  }
+  watcher_stop_fd_ = eventfd(0, EFD_CLOEXEC);
+  watcher_ = std::thread(&basic_File::watcher_loop, this, inotify_fd,
+                         path.filename().string());
+  watching_ = true;
+  return true;
+#else
+  CRACON_LOG_ERROR("Watching the configuration is only supported on Linux\n");
+  return false;
+#endif
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::stop_watcher() {
+  watching_ = false;
+  if (!watcher_.joinable()) {
+    return;
+  }
+#ifdef __linux__
+  std::uint64_t const stop = 1;
+  (void)!::write(watcher_stop_fd_, &stop, sizeof(stop));
+  watcher_.join();
+  close(watcher_stop_fd_);
+  watcher_stop_fd_ = -1;
+#endif
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::watcher_loop(int inotify_fd,
+                                     std::string const &filename) {
+#ifdef __linux__
+  alignas(inotify_event) char buffer[4096];
+  pollfd fds[2] = {{watcher_stop_fd_, POLLIN, 0}, {inotify_fd, POLLIN, 0}};
+  while (poll(fds, 2, -1) >= 0 && !(fds[0].revents & POLLIN)) {
+    if (!(fds[1].revents & POLLIN)) {
+      continue;
+    }
+    auto const length = read(inotify_fd, buffer, sizeof(buffer));
+    bool changed = false;
+    for (ssize_t i = 0; i < length;) {
+      auto const *event = reinterpret_cast<inotify_event const *>(buffer + i);
+      if (event->len > 0 &&
+          (filename.empty()
+               ? std::filesystem::path(event->name).extension() == ".json"
+               : filename == event->name)) {
+        changed = true;
+      }
+      i += sizeof(inotify_event) + event->len;
+    }
+    if (changed) {
+      reload();
+    }
+  }
+  close(inotify_fd);
+#else
+  (void)inotify_fd;
+  (void)filename;
+#endif
+}
+
+template <typename JsonT>
+std::string basic_File<JsonT>::relative_path(
+    std::string const &filename) const {
+  std::filesystem::path folder(filename_config_);
+  if (!directory_) {
+    folder = folder.parent_path();
+  }
+  return (folder / filename).string();
+}
+
+template <typename JsonT>
+std::shared_ptr<detail::MappedFile const> basic_File<JsonT>::open_blob(
+    JsonT const &reference, char const *dtype,
+    std::size_t element_size, std::vector<std::size_t> &shape) const {
+  auto const name = reference.is_object() ? reference.find("$blob")
+                                          : reference.end();
+  if (name == reference.end() || !name->is_string()) {
+    CRACON_LOG_ERROR("Not a blob reference: %s\n", reference.dump().c_str());
+    return nullptr;
+  }
+  auto const &filename = name->template get_ref<std::string const &>();
+  // The dtype defaults to the extension, i.e. "f32" for "table.f32"
+  std::string expected_dtype =
+      std::filesystem::path(filename).extension().string();
+  if (!expected_dtype.empty()) {
+    expected_dtype.erase(0, 1);
+  }
+  auto const dtype_it = reference.find("dtype");
+  if (dtype_it != reference.end() && dtype_it->is_string()) {
+    expected_dtype = dtype_it->template get<std::string>();
+  }
+  if (expected_dtype != dtype) {
+    CRACON_LOG_ERROR("The blob %s holds %s, not %s\n", filename.c_str(),
+                     expected_dtype.c_str(), dtype);
+    return nullptr;
+  }
+  auto file = detail::MappedFile::open(relative_path(filename));
+  if (file == nullptr) {
+    CRACON_LOG_ERROR("Couldn't open the blob %s\n", filename.c_str());
+    return nullptr;
+  }
+  shape.clear();
+  auto const shape_it = reference.find("shape");
+  if (shape_it == reference.end()) {
+    shape.push_back(file->size() / element_size);
+  } else if (!is_similar<std::vector<std::size_t>>(*shape_it)) {
+    CRACON_LOG_ERROR("Invalid shape for the blob %s\n", filename.c_str());
+    return nullptr;
+  } else {
+    shape = shape_it->template get<std::vector<std::size_t>>();
+  }
+  std::size_t size = element_size;
+  for (auto dimension : shape) {
+    // A corrupt shape could wrap around to the size of the file.
+    if (dimension != 0 &&
+        size > std::numeric_limits<std::size_t>::max() / dimension) {
+      CRACON_LOG_ERROR("The shape of the blob %s overflows\n",
+                       filename.c_str());
+      return nullptr;
+    }
+    size *= dimension;
+  }
+  if (size != file->size()) {
+    CRACON_LOG_ERROR("The blob %s is %zu bytes, its shape needs %zu\n",
+                     filename.c_str(), file->size(), size);
+    return nullptr;
+  }
+  return file;
+}
+
+template <typename JsonT>
+bool basic_File<JsonT>::write_blob(Key const &key,
+                                   std::string const &blob_filename,
+                                   char const *dtype, void const *data,
+                                   std::size_t size,
+                                   std::vector<std::size_t> const &shape) {
+  auto const path = relative_path(blob_filename);
+  {
+    std::unique_lock write_lock(write_mutex_);
+    auto const existing = detail::MappedFile::open(path);
+    if (existing != nullptr && existing->size() == size &&
+        (size == 0 || std::memcmp(existing->data(), data, size) == 0)) {
+      skipped_writes_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      // Replaced, not overwritten, so mapped blobs keep their data.
+      auto const temporary = path + ".tmp";
+      std::ofstream output_file(temporary, std::ios::out | std::ios::binary);
+      output_file.write(static_cast<char const *>(data),
+                        static_cast<std::streamsize>(size));
+      output_file.close();
+      std::error_code error;
+      if (!output_file ||
+          (std::filesystem::rename(temporary, path, error), error)) {
+        CRACON_LOG_ERROR("Error writing the blob %s\n", path.c_str());
+        return false;
+      }
+      writes_.fetch_add(1, std::memory_order_relaxed);
+      bytes_written_.fetch_add(size, std::memory_order_relaxed);
+    }
+  }
+  JsonT const reference = {
+      {"$blob", blob_filename}, {"dtype", dtype}, {"shape", shape}};
+  sets_.fetch_add(1, std::memory_order_relaxed);
+  auto const *current = cracon::find(snapshot()->file_content(), key);
+  if (current != nullptr && *current == reference) {
+    return true;
+  }
+  apply_change(key, [&](JsonT &config) {
+    config[key.pointer()] = reference;
+  });
+  return true;
+}
+
+template <typename JsonT>
+typename basic_File<JsonT>::Stats basic_File<JsonT>::stats() const {
+  Stats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.type_mismatches = type_mismatches_.load(std::memory_order_relaxed);
+  stats.gets = stats.hits + stats.misses + stats.type_mismatches;
+  stats.sets = sets_.load(std::memory_order_relaxed);
+  stats.writes = writes_.load(std::memory_order_relaxed);
+  stats.skipped_writes = skipped_writes_.load(std::memory_order_relaxed);
+  stats.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+  stats.write_latency = write_latency_.load();
+  stats.lock_wait = lock_wait_.load();
+  return stats;
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::apply_change(Key const &key, Change const &change) {
+  auto const publish_change = [&] {
+    auto next = next_snapshot();
+    apply(*next, key, change);
+    publish(std::move(next));
+    should_write_config_ = true;
+    notify_change();
+  };
+  if (!key.tokens().empty()) {
+    auto lock = lock_module(key.tokens().front());
+    // Only the writers of the whole configuration, excluded by the lock, make
+    // it an object or not.
+    if (snapshot()->object) {
+      publish_change();
+      return;
+    }
+  }
+  auto lock = lock_config();
+  publish_change();
+}
+
+template <typename JsonT>
+std::shared_ptr<typename basic_File<JsonT>::Snapshot>
+basic_File<JsonT>::next_snapshot() const {
+  auto const current = snapshot();
+  auto next = std::make_shared<Snapshot>();
+  next->modules = current->modules;
+  next->object = current->object;
+  next->layered = current->layered;
+  // The generation it is a copy of, see publish().
+  next->generation = current->generation;
+  if (!current->object) {
+    next->config_ = current->config_;
+    next->file_content_ = current->file_content_;
+  }
+  return next;
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::apply(Snapshot &next, Key const &key,
+                              Change const &change) {
+  auto const &tokens = key.tokens();
+  if (tokens.empty() || !next.object) {
+    // Changed on a copy, thus a throwing change replaces nothing.
+    auto content = next.file_content();
+    change(content);
+    if (directory_) {
+      // Each module is a file, named after it.
+      if (!content.is_object()) {
+        throw std::invalid_argument("The modules must be in an object");
+      }
+      for (auto const &module : content.items()) {
+        detail::check_module_name(module.key());
+      }
+    }
+    split(next, std::move(content), nullptr);
+    next.all_changed = true;
+    return;
+  }
+  auto const &name = tokens.front();
+  if (directory_) {
+    detail::check_module_name(name);
+  }
+  auto &module = own(next, name);
+  // The change sees the module at its place in the configuration.
+  auto &content = next.layered ? module.layer : module.value;
+  auto root = JsonT::object();
+  if (content) {
+    root[name] = std::move(*content);
+  }
+  auto const restore = [&] {
+    auto const it = root.find(name);
+    if (it != root.end()) {
+      content = std::move(*it);
+    } else {
+      content.reset();
+    }
+  };
+  try {
+    change(root);
+  } catch (...) {
+    restore();
+    throw;
+  }
+  restore();
+  if (next.layered) {
+    // Merged from the top of the module: an ancestor of key in the file, i.e.
+    // {"motor": null}, replaces the one of the lower layers.
+    module.value.reset();
+    if (!module.layer || !module.layer->is_null()) {
+      auto const base = base_.find(name);
+      if (base != base_.end()) {
+        module.value = *base;
+      }
+      if (module.layer) {
+        if (!module.value) {
+          module.value.emplace();
+        }
+        module.value->merge_patch(*module.layer);
+      }
+    }
+  }
+  module.index.clear();
+  module.indexed = false;
+  if (!module.value && !module.layer) {
+    next.modules.erase(name);
+  }
+  next.config_.reset();
+  next.file_content_.reset();
+}
+
+template <typename JsonT>
+typename basic_File<JsonT>::Snapshot::Module &basic_File<JsonT>::own(
+    Snapshot &next, std::string const &name) {
+  auto &slot = next.modules[name];
+  auto const &changed_modules = next.changed_modules;
+  bool const changed = next.all_changed ||
+                       std::find(changed_modules.begin(), changed_modules.end(),
+                                 name) != changed_modules.end();
+  if (slot != nullptr && changed) {
+    // Created for next, which isn't published yet.
+    return const_cast<typename Snapshot::Module &>(*slot);
+  }
+  auto module = std::make_shared<typename Snapshot::Module>();
+  if (slot != nullptr) {
+    // Copied on the heap, outside of any ArenaScope.
+    module->value = slot->value;
+    module->layer = slot->layer;
+    module->order = slot->order;
+  } else {
+    module->order = module_order_++;
+  }
+  slot = module;
+  if (!changed) {
+    next.changed_modules.push_back(name);
+  }
+  return *module;
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::split(Snapshot &next, JsonT content,
+                              std::shared_ptr<Arena> const &arena) {
+  using Module = typename Snapshot::Module;
+  next.modules.clear();
+  next.changed_modules.clear();
+  next.all_changed = false;
+  next.layered = !options_.layers.empty();
+  next.config_.reset();
+  next.file_content_.reset();
+  JsonT merged;
+  if (next.layered) {
+    merged = base_;
+    merged.merge_patch(content);
+  }
+  next.object = content.is_object() && (!next.layered || merged.is_object());
+  if (!next.object) {
+    if (next.layered) {
+      next.file_content_ = std::make_shared<JsonT const>(std::move(content));
+      next.config_ = std::make_shared<JsonT const>(std::move(merged));
+    } else {
+      next.config_ = std::make_shared<JsonT const>(std::move(content));
+    }
+    return;
+  }
+  std::map<std::string, std::shared_ptr<Module>, std::less<>> modules;
+  for (auto &item : content.items()) {
+    auto &module = modules[item.key()];
+    module = std::make_shared<Module>();
+    module->arena = arena;
+    module->order = module_order_++;
+    (next.layered ? module->layer : module->value) = std::move(item.value());
+  }
+  if (next.layered) {
+    for (auto &item : merged.items()) {
+      auto &module = modules[item.key()];
+      if (module == nullptr) {
+        // Only in the lower layers
+        module = std::make_shared<Module>();
+        module->order = module_order_++;
+      }
+      module->value = std::move(item.value());
+    }
+  }
+  for (auto &[name, module] : modules) {
+    if (options_.index) {
+      detail::index_module(name, *module);
+    }
+    next.modules.emplace(name, std::move(module));
+  }
+}
+
+template <typename JsonT>
+std::unique_lock<std::shared_mutex> basic_File<JsonT>::lock_config() {
+  std::unique_lock lock(mutex_, std::try_to_lock);
+  if (lock.owns_lock()) {
+    lock_wait_.record(std::chrono::nanoseconds(0));
+    return lock;
+  }
+  auto const start = std::chrono::steady_clock::now();
+  lock.lock();
+  lock_wait_.record(std::chrono::steady_clock::now() - start);
+  return lock;
+}
+
+template <typename JsonT>
+typename basic_File<JsonT>::ModuleLock basic_File<JsonT>::lock_module(
+    std::string const &name) {
+  // Always mutex_ first, then the module.
+  ModuleLock lock{std::shared_lock(mutex_, std::try_to_lock),
+                  std::unique_lock(module_mutexes_[detail::fnv1a(name) %
+                                                   module_mutexes_.size()],
+                                   std::defer_lock)};
+  if (lock.first.owns_lock() && lock.second.try_lock()) {
+    lock_wait_.record(std::chrono::nanoseconds(0));
+    return lock;
+  }
+  auto const start = std::chrono::steady_clock::now();
+  if (!lock.first.owns_lock()) {
+    lock.first.lock();
+  }
+  lock.second.lock();
+  lock_wait_.record(std::chrono::steady_clock::now() - start);
+  return lock;
+}
+
+template <typename JsonT>
+void basic_File<JsonT>::publish(std::shared_ptr<Snapshot> next) {
+  if (options_.index) {
+    for (auto const &module : next->modules) {
+      if (!module.second->indexed) {
+        // Changed for next, thus its own.
+        detail::index_module(module.first, own(*next, module.first));
+      }
+    }
+  }
+  auto current = snapshot();
+  auto copied = next->generation;
+  std::shared_ptr<Snapshot const> const published = next;
+  while (true) {
+    if (current->generation != copied && !next->changed_modules.empty()) {
+      // Writers of other modules published meanwhile: their modules are kept.
+      assert(!next->all_changed);
+      auto modules = current->modules;
+      for (auto const &name : next->changed_modules) {
+        auto const it = next->modules.find(name);
+        if (it != next->modules.end()) {
+          modules[name] = it->second;
+        } else {
+          modules.erase(name);
+        }
+      }
+      next->modules = std::move(modules);
+      copied = current->generation;
+    }
+    next->generation = current->generation + 1;
+    if (std::atomic_compare_exchange_weak(&snapshot_, &current, published)) {
+      break;
+    }
+  }
+  if (directory_ && (next->all_changed || !next->changed_modules.empty())) {
+    std::unique_lock lock(modules_mutex_);
+    if (next->all_changed) {
+      dirty_modules_[""] = next->generation;
+    }
+    for (auto const &name : next->changed_modules) {
+      dirty_modules_[name] = next->generation;
+    }
+  }
+}
+
+template <typename JsonT>
+basic_SharedFile<JsonT>::basic_SharedFile(
+    std::string const &filename_config, std::string const &filename_default,
+    Options const &options) {
+  init(filename_config, filename_default, options);
+}
+
+template <typename JsonT>
+bool basic_SharedFile<JsonT>::init(std::string const &filename_config,
+                                   std::string const &filename_default,
+                                   Options const &options) {
+  return file_->init(filename_config, filename_default, options);
+}
+
+template <typename JsonT>
+bool basic_SharedFile<JsonT>::should_write() {
+  return file_->should_write();
+}
+
+template <typename JsonT>
+bool basic_SharedFile<JsonT>::write() { return file_->write(); }
+
+template <typename JsonT>
+std::future<bool> basic_SharedFile<JsonT>::flush() { return file_->flush(); }
+
+}  // namespace cracon
+
+#endif  // CRACON_CRACON_IMPL_HPP
@@ -0,0 +1,29 @@
+#ifndef CRACON_FIELDS_HPP
+#define CRACON_FIELDS_HPP
+
+#include <nlohmann/json.hpp>
+
+/**
+ * @brief Lists the fields of a struct to load and store it in one pass, see
+ * File::bind and File::store.
+ *
+ * Use it in the namespace of the struct, the fields are found by ADL:
+ *
+ *   struct Car { int64_t speed = 9000; int64_t horsepower = 120; };
+ *   CRACON_STRUCT(Car, speed, horsepower)
+ *
+ * Each field is stored under its name. Up to 63 fields.
+ */
+#define CRACON_STRUCT(Type, ...)                                             \
+  template <typename Visitor>                                                \
+  void cracon_fields(Type &object, Visitor &&visitor) {                      \
+    NLOHMANN_JSON_EXPAND(NLOHMANN_JSON_PASTE(CRACON_FIELD, __VA_ARGS__))     \
+  }                                                                          \
+  template <typename Visitor>                                                \
+  void cracon_fields(Type const &object, Visitor &&visitor) {                \
+    NLOHMANN_JSON_EXPAND(NLOHMANN_JSON_PASTE(CRACON_FIELD, __VA_ARGS__))     \
+  }
+
+#define CRACON_FIELD(field) visitor(#field, object.field);
+
+#endif  // CRACON_FIELDS_HPP
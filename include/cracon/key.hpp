@@ -0,0 +1,270 @@
+#ifndef CRACON_KEY_HPP
+#define CRACON_KEY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cracon {
+namespace detail {
+constexpr std::uint64_t fnv1a_offset = 14695981039346656037ULL;
+constexpr std::uint64_t fnv1a_prime = 1099511628211ULL;
+
+/**
+ * @brief 64 bits FNV-1a hash, stable across platforms and runs.
+ *
+ * Passing the hash of "a" as seed gives the hash of "a" + data.
+ */
+constexpr std::uint64_t fnv1a(std::string_view data,
+                              std::uint64_t seed = fnv1a_offset) {
+  for (char c : data) {
+    seed = (seed ^ static_cast<unsigned char>(c)) * fnv1a_prime;
+  }
+  return seed;
+}
+
+/**
+ * @brief True if accessor is a valid JSON pointer (RFC 6901): empty or
+ * starting with '/', each '~' being followed by '0' or '1'.
+ */
+constexpr bool is_valid_pointer(std::string_view accessor) {
+  if (!accessor.empty() && accessor[0] != '/') {
+    return false;
+  }
+  for (std::size_t i = 0; i < accessor.size(); i++) {
+    if (accessor[i] != '~') {
+      continue;
+    }
+    if (i + 1 == accessor.size() ||
+        (accessor[i + 1] != '0' && accessor[i + 1] != '1')) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace detail
+
+/**
+ * @brief Precompiled JSON pointer to a parameter.
+ *
+ * The accessor is parsed and validated once, at construction. Passing a Key to
+ * File::get/set avoids building a new json_pointer on every access.
+ *
+ * Keys are implicitly constructible from strings, thus `file.get("/int", 1)`
+ * keeps working. Invalid pointers (i.e. "int" without the leading slash) throw
+ * nlohmann::json::parse_error.
+ */
+class Key {
+ public:
+  /**
+   * @brief The root key, pointing to the whole document.
+   */
+  Key() = default;
+  Key(std::string const &accessor)
+      : pointer_(accessor),
+        tokens_(split(accessor)),
+        path_(accessor),
+        hash_(detail::fnv1a(accessor)) {}
+  Key(char const *accessor) : Key(std::string(accessor)) {}
+
+  /**
+   * @brief Creates a child key.
+   *
+   * @param relative Path relative to this key, without the leading slash. It
+   * can contain multiple levels: "it/does"
+   * @return Key The combined key, i.e. Key("/car") / "speed" is "/car/speed"
+   */
+  [[nodiscard]] Key operator/(std::string const &relative) const {
+    // Appends the tokens to a copy of this key instead of parsing and
+    // concatenating a second pointer.
+    Key result = *this;
+    result.path_ += '/';
+    result.path_ += relative;
+    auto const appended = std::string_view(result.path_).substr(path_.size());
+    if (!detail::is_valid_pointer(appended)) {
+      return *this / Key("/" + relative);  // Throws json::parse_error
+    }
+    result.hash_ = detail::fnv1a(appended, hash_);
+    for (auto &token : split(appended)) {
+      result.pointer_.push_back(token);
+      result.tokens_.push_back(std::move(token));
+    }
+    return result;
+  }
+  [[nodiscard]] Key operator/(char const *relative) const {
+    return *this / std::string(relative);
+  }
+
+  /**
+   * @brief Appends a key to this key. Key("/car") / Key("/speed") is
+   * "/car/speed"
+   */
+  [[nodiscard]] Key operator/(Key const &relative) const {
+    Key result;
+    result.pointer_ = pointer_ / relative.pointer_;
+    result.tokens_ = tokens_;
+    result.tokens_.insert(result.tokens_.end(), relative.tokens_.begin(),
+                          relative.tokens_.end());
+    result.path_ = path_ + relative.path_;
+    result.hash_ = detail::fnv1a(relative.path_, hash_);
+    return result;
+  }
+
+  /**
+   * @brief The parsed json pointer
+   */
+  [[nodiscard]] nlohmann::json::json_pointer const &pointer() const {
+    return pointer_;
+  }
+
+  /**
+   * @brief The unescaped reference tokens, i.e. {"a/b", "c"} for "/a~1b/c"
+   */
+  [[nodiscard]] std::vector<std::string> const &tokens() const {
+    return tokens_;
+  }
+
+  /**
+   * @brief The accessor in the form "/some_module/some_parameter"
+   */
+  [[nodiscard]] std::string const &str() const { return path_; }
+
+  /**
+   * @brief FNV-1a hash of str()
+   */
+  [[nodiscard]] std::uint64_t hash() const { return hash_; }
+
+  bool operator==(Key const &other) const { return path_ == other.path_; }
+  bool operator!=(Key const &other) const { return path_ != other.path_; }
+
+ private:
+  // Only called on pointers validated by json_pointer.
+  static std::vector<std::string> split(std::string_view accessor) {
+    std::vector<std::string> tokens;
+    for (std::size_t i = 0; i < accessor.size(); i++) {
+      if (accessor[i] == '/') {
+        tokens.emplace_back();
+      } else if (accessor[i] == '~') {
+        tokens.back() += accessor[++i] == '0' ? '~' : '/';
+      } else {
+        tokens.back() += accessor[i];
+      }
+    }
+    return tokens;
+  }
+
+  nlohmann::json::json_pointer pointer_;
+  std::vector<std::string> tokens_;
+  std::string path_;
+  std::uint64_t hash_ = detail::fnv1a("");
+};
+
+#if defined(__cpp_nontype_template_args) && \
+    __cpp_nontype_template_args >= 201911L
+/**
+ * @brief String literal usable as a template argument, see key().
+ */
+template <std::size_t N>
+struct FixedString {
+  constexpr FixedString(char const (&str)[N]) {
+    for (std::size_t i = 0; i < N; i++) {
+      data[i] = str[i];
+    }
+  }
+  [[nodiscard]] constexpr std::string_view view() const {
+    return std::string_view(data, N - 1);
+  }
+  char data[N] = {};
+};
+
+/**
+ * @brief Key validated at compile time and built once, on first use.
+ *
+ *   file.get(cracon::key<"/car/speed">(), 9000);
+ *
+ * Requires C++20, see CRACON_KEY for C++17.
+ */
+template <FixedString accessor>
+[[nodiscard]] Key const &key() {
+  static_assert(detail::is_valid_pointer(accessor.view()),
+                "Invalid JSON pointer, it must start with '/' and escape '~' "
+                "as '~0'");
+  static Key const compiled(std::string(accessor.view()));
+  return compiled;
+}
+#endif
+
+/**
+ * @brief Key validated at compile time and built once, on first use.
+ *
+ *   file.get(CRACON_KEY("/car/speed"), 9000);
+ *
+ * The C++17 equivalent of cracon::key<"/car/speed">().
+ */
+#define CRACON_KEY(accessor)                                                 \
+  ([]() -> ::cracon::Key const & {                                           \
+    static_assert(::cracon::detail::is_valid_pointer(accessor),              \
+                  "Invalid JSON pointer, it must start with '/' and escape " \
+                  "'~' as '~0'");                                            \
+    static ::cracon::Key const compiled(accessor);                           \
+    return compiled;                                                         \
+  }())
+
+/**
+ * @brief Finds the value at the key, without throwing nor creating it.
+ *
+ * @param root The json document
+ * @param key The location of the value
+ * @param skip The first tokens of key, already resolved to root, i.e. 1 if
+ * root is the value at the first token
+ * @return A pointer to the value or nullptr if it doesn't exist
+ */
+template <typename JsonT>
+[[nodiscard]] JsonT const *find(JsonT const &root, Key const &key,
+                                std::size_t skip = 0) {
+  JsonT const *node = &root;
+  auto const &tokens = key.tokens();
+  for (auto it = tokens.begin() + std::min(skip, tokens.size());
+       it != tokens.end(); ++it) {
+    auto const &token = *it;
+    if (node->is_object()) {
+      auto it = node->find(token);
+      if (it == node->end()) {
+        return nullptr;
+      }
+      node = &*it;
+    } else if (node->is_array()) {
+      // Array indexes are digits without leading zeros. "-" is past the end.
+      if (token.empty() || (token.size() > 1 && token[0] == '0')) {
+        return nullptr;
+      }
+      std::size_t index = 0;
+      for (char c : token) {
+        if (c < '0' || c > '9') {
+          return nullptr;
+        }
+        auto const digit = static_cast<std::size_t>(c - '0');
+        if (index > (std::numeric_limits<std::size_t>::max() - digit) / 10) {
+          return nullptr;  // Overflows, thus past the end
+        }
+        index = index * 10 + digit;
+      }
+      if (index >= node->size()) {
+        return nullptr;
+      }
+      node = &(*node)[index];
+    } else {
+      return nullptr;
+    }
+  }
+  return node;
+}
+
+}  // namespace cracon
+
+#endif  // CRACON_KEY_HPP
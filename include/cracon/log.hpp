@@ -1,13 +1,100 @@
 #ifndef CRACON_LOG_HPP
 #define CRACON_LOG_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <functional>
+
+namespace cracon {
+
+enum class LogLevel { debug, info, warning, error, off };
+
+/**
+ * @brief Receives the formatted log messages, without the "[cracon] [LEVEL] "
+ * prefix. It can be called from any thread.
+ */
+using LogSink = std::function<void(LogLevel level, char const *message)>;
+
+/**
+ * @brief Replaces the sink of the log messages. nullptr restores the default
+ * sink, printing to stdout (debug, info) and stderr (warning, error).
+ */
+void set_log_sink(LogSink sink);
+
+/**
+ * @brief Messages below level are dropped before being formatted. Defaults to
+ * LogLevel::debug.
+ */
+void set_log_level(LogLevel level);
+
+/**
+ * @brief Maximum number of messages per second from each log statement about
+ * each key, 0 for unlimited. Defaults to 10; the messages above it are dropped.
+ */
+void set_log_rate_limit(std::uint32_t messages_per_second);
+
+/**
+ * @brief Wraps sink so it is called from a background thread.
+ *
+ * Messages are queued in a lock-free ring buffer of capacity messages, thus
+ * logging never waits for sink nor allocates. Loading the current sink still
+ * takes a short lock from the global pool of std::atomic_load on libstdc++
+ * and MSVC. Messages are dropped when the ring is full and truncated to 255
+ * characters. The thread stops, after forwarding the
+ * queued messages, once the returned sink is destroyed.
+ */
+[[nodiscard]] LogSink make_async_log_sink(LogSink sink,
+                                          std::size_t capacity = 1024);
+
+namespace detail {
+extern std::atomic<int> log_level;
+
+inline bool log_enabled(LogLevel level) {
+  return static_cast<int>(level) >=
+         log_level.load(std::memory_order_relaxed);
+}
+
+// Formats the message and passes it to the sink.
+#if defined(__GNUC__)
+__attribute__((format(printf, 2, 3)))
+#endif
+void log(LogLevel level, char const *format, ...);
+
+// Counts the messages of statement about key, the hash of a Key or 0, within
+// the current second. True if it is below the rate limit.
+bool log_allowed(void const *statement, std::uint64_t key);
+}  // namespace detail
+}  // namespace cracon
+
+// The arguments are only evaluated, thus i.e. dump() only called, if the
+// message is emitted.
+#define CRACON_LOG_KEYED_IMPL(level, key, ...)                          \
+  do {                                                                  \
+    static char const cracon_log_statement = 0;                         \
+    if (::cracon::detail::log_enabled(level) &&                         \
+        ::cracon::detail::log_allowed(&cracon_log_statement, (key))) {  \
+      ::cracon::detail::log(level, __VA_ARGS__);                        \
+    }                                                                   \
+  } while (false)
+#define CRACON_LOG_IMPL(level, ...) CRACON_LOG_KEYED_IMPL(level, 0, __VA_ARGS__)
 
 #ifdef CRACON_ENABLE_LOG
-#define CRACON_LOG_IMPL_DEBUG(...) fprintf(stdout, __VA_ARGS__)
-#define CRACON_LOG_IMPL_INFO(...) fprintf(stdout, __VA_ARGS__)
-#define CRACON_LOG_IMPL_WARNING(...) fprintf(stderr, __VA_ARGS__)
-#define CRACON_LOG_IMPL_ERROR(...) fprintf(stderr, __VA_ARGS__)
+#define CRACON_LOG_IMPL_DEBUG(...) \
+  CRACON_LOG_IMPL(::cracon::LogLevel::debug, __VA_ARGS__)
+#define CRACON_LOG_IMPL_INFO(...) \
+  CRACON_LOG_IMPL(::cracon::LogLevel::info, __VA_ARGS__)
+#define CRACON_LOG_IMPL_WARNING(...) \
+  CRACON_LOG_IMPL(::cracon::LogLevel::warning, __VA_ARGS__)
+#define CRACON_LOG_IMPL_ERROR(...) \
+  CRACON_LOG_IMPL(::cracon::LogLevel::error, __VA_ARGS__)
+#define CRACON_LOG_IMPL_KEYED_INFO(key, ...) \
+  CRACON_LOG_KEYED_IMPL(::cracon::LogLevel::info, key, __VA_ARGS__)
+#define CRACON_LOG_IMPL_KEYED_WARNING(key, ...) \
+  CRACON_LOG_KEYED_IMPL(::cracon::LogLevel::warning, key, __VA_ARGS__)
+#define CRACON_LOG_IMPL_KEYED_ERROR(key, ...) \
+  CRACON_LOG_KEYED_IMPL(::cracon::LogLevel::error, key, __VA_ARGS__)
 #else
 #define CRACON_LOG_IMPL_DEBUG(...) \
   {}
@@ -17,15 +104,24 @@
   {}
 #define CRACON_LOG_IMPL_ERROR(...) \
   {}
+#define CRACON_LOG_IMPL_KEYED_INFO(key, ...) \
+  {}
+#define CRACON_LOG_IMPL_KEYED_WARNING(key, ...) \
+  {}
+#define CRACON_LOG_IMPL_KEYED_ERROR(key, ...) \
+  {}
 #endif
 
-#define CRACON_LOG_DEBUG(...) \
-  CRACON_LOG_IMPL_DEBUG("[cracon] [DEBUG] " __VA_ARGS__)
-#define CRACON_LOG_INFO(...) \
-  CRACON_LOG_IMPL_INFO("[cracon] [INFO] " __VA_ARGS__)
-#define CRACON_LOG_WARNING(...) \
-  CRACON_LOG_IMPL_WARNING("[cracon] [WARN] " __VA_ARGS__)
-#define CRACON_LOG_ERROR(...) \
-  CRACON_LOG_IMPL_ERROR("[cracon] [ERROR] " __VA_ARGS__)
+#define CRACON_LOG_DEBUG(...) CRACON_LOG_IMPL_DEBUG(__VA_ARGS__)
+#define CRACON_LOG_INFO(...) CRACON_LOG_IMPL_INFO(__VA_ARGS__)
+#define CRACON_LOG_WARNING(...) CRACON_LOG_IMPL_WARNING(__VA_ARGS__)
+#define CRACON_LOG_ERROR(...) CRACON_LOG_IMPL_ERROR(__VA_ARGS__)
+// Rate limited per key, the Key::hash() of the parameter the message is about.
+#define CRACON_LOG_KEYED_INFO(key, ...) \
+  CRACON_LOG_IMPL_KEYED_INFO(key, __VA_ARGS__)
+#define CRACON_LOG_KEYED_WARNING(key, ...) \
+  CRACON_LOG_IMPL_KEYED_WARNING(key, __VA_ARGS__)
+#define CRACON_LOG_KEYED_ERROR(key, ...) \
+  CRACON_LOG_IMPL_KEYED_ERROR(key, __VA_ARGS__)
 
 #endif
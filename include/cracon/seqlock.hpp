@@ -0,0 +1,79 @@
+#ifndef CRACON_SEQLOCK_HPP
+#define CRACON_SEQLOCK_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace cracon {
+
+/**
+ * @brief Holds a trivially copyable value read without locking nor allocating.
+ *
+ * The writer bumps the sequence to an odd number, copies the value and bumps
+ * it back to an even number. A reader copies the value and retries only if a
+ * write happened meanwhile, thus reads never block and never wait for a
+ * reader. The value is stored in atomic words so a racing copy is well
+ * defined, it is discarded anyway.
+ *
+ * Writers must be serialized by the caller.
+ */
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Seqlock requires a trivially copyable type");
+  static_assert(std::is_default_constructible_v<T>,
+                "Seqlock requires a default constructible type");
+
+ public:
+  explicit Seqlock(T const &value = T()) { store(value); }
+
+  /**
+   * @brief Copies the last stored value.
+   */
+  [[nodiscard]] T load() const {
+    Words words;
+    std::size_t before = 0;
+    std::size_t after = 0;
+    do {
+      before = sequence_.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i < kWords; i++) {
+        words[i] = data_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence_.load(std::memory_order_relaxed);
+    } while (before != after || (before & 1) != 0);
+    T value;
+    std::memcpy(&value, words.data(), sizeof(T));
+    return value;
+  }
+
+  /**
+   * @brief Replaces the value. Only one writer at a time.
+   */
+  void store(T const &value) {
+    Words words{};
+    std::memcpy(words.data(), &value, sizeof(T));
+    auto const sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < kWords; i++) {
+      data_[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+ private:
+  static constexpr std::size_t kWords =
+      (sizeof(T) + sizeof(std::size_t) - 1) / sizeof(std::size_t);
+  using Words = std::array<std::size_t, kWords>;
+
+  std::atomic<std::size_t> sequence_ = 0;
+  std::array<std::atomic<std::size_t>, kWords> data_{};
+};
+
+}  // namespace cracon
+
+#endif  // CRACON_SEQLOCK_HPP
@@ -2,6 +2,7 @@
 #define CRACON_SIMILARITY_TRAIT_HPP
 
 #include <cassert>
+#include <cracon/log.hpp>
 #include <cstdint>
 #include <iostream>
 #include <limits>
@@ -41,21 +42,21 @@ struct is_array<std::array<T, N>> : public std::true_type {};
  * @return true Similar type (can be safely converted)
  * @return false Dissimilar type (can't be parsed)
  */
-template <typename T>
-bool is_similar(nlohmann::json const &value) {
+template <typename T, typename JsonT>
+bool is_similar(JsonT const &value) {
   if constexpr (std::is_same_v<T, bool>) {
     return value.is_boolean();
   } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
     bool result = value.is_number_integer();
     if (result)  // Limit checks
     {
-      int64_t parsed_value = value.get<int64_t>();
+      int64_t parsed_value = value.template get<int64_t>();
       if (parsed_value < std::numeric_limits<T>::lowest()) {
-        fprintf(stderr, "[cracon] [WARN] Out of bounds (min)\n");
+        CRACON_LOG_WARNING("Out of bounds (min)\n");
 
         return false;
       } else if (parsed_value > std::numeric_limits<T>::max()) {
-        fprintf(stderr, "[cracon] [WARN] Out of bounds (max)\n");
+        CRACON_LOG_WARNING("Out of bounds (max)\n");
         return false;
       }
     }
@@ -64,12 +65,13 @@ bool is_similar(nlohmann::json const &value) {
     bool result = value.is_number_integer();
     if (result)  // Limit checks
     {
-      int64_t parsed_value = value.get<int64_t>();
+      int64_t parsed_value = value.template get<int64_t>();
       if (parsed_value < 0) {
-        fprintf(stderr, "[cracon] [WARN] Out of bounds (min) \n");
+        CRACON_LOG_WARNING("Out of bounds (min) \n");
         return false;
-      } else if (parsed_value > std::numeric_limits<T>::max()) {
-        fprintf(stderr, "[cracon] [WARN] Out of bounds (max)\n");
+      } else if (static_cast<std::uint64_t>(parsed_value) >
+                 std::numeric_limits<T>::max()) {
+        CRACON_LOG_WARNING("Out of bounds (max)\n");
         return false;
       }
     }
@@ -78,12 +80,12 @@ bool is_similar(nlohmann::json const &value) {
     bool result = value.is_number_float();
     if (result)  // Limit checks
     {
-      double high_limit = value.get<double>();
+      double high_limit = value.template get<double>();
       if (high_limit < std::numeric_limits<T>::lowest()) {
-        fprintf(stderr, "[cracon] [WARN] Out of bounds (min) \n");
+        CRACON_LOG_WARNING("Out of bounds (min) \n");
         return false;
       } else if (high_limit > std::numeric_limits<T>::max()) {
-        fprintf(stderr, "[cracon] [WARN] Out of bounds (max)\n");
+        CRACON_LOG_WARNING("Out of bounds (max)\n");
         return false;
       }
     }
@@ -114,13 +116,13 @@ bool is_similar(nlohmann::json const &value) {
     return false;
   } else if constexpr (std::is_enum_v<T>) {
     if (value.is_number_integer()) {
-      int high_limit = value.get<int>();
+      int high_limit = value.template get<int>();
       if (high_limit < 0) {
-        fprintf(stderr, "[cracon] [WARN] Enums have to be >0\n");
+        CRACON_LOG_WARNING("Enums have to be >0\n");
         return false;
       } else if (high_limit > std::pow(2, sizeof(T) * 8 - 1)) {
         // The value has to be representable in the enum
-        fprintf(stderr, "[cracon] [WARN] Out of bounds (max)\n");
+        CRACON_LOG_WARNING("Out of bounds (max)\n");
         return false;
       }
       return true;
@@ -128,9 +130,153 @@ bool is_similar(nlohmann::json const &value) {
     return false;
   }
 
-  fprintf(stderr, "[cracon] [ERROR] type is not supported\n");
+  CRACON_LOG_ERROR("type is not supported\n");
   return false;
 }
+
+/**
+ * @brief Converts the JSON value to T if it is similar, see is_similar.
+ *
+ * Equivalent to `is_similar<T>(value)` followed by `value.get<T>()`, in a
+ * single pass: each element of an array is checked and converted at once,
+ * directly into the storage of `out`, preallocated to the size of the array.
+ *
+ * @tparam T Output type
+ * @param value The JSON value to convert
+ * @param out Receives the value. Unspecified if the value isn't similar.
+ * @return true Similar type, out holds the value
+ * @return false Dissimilar type (can't be parsed)
+ */
+template <typename T, typename JsonT>
+bool try_get(JsonT const &value, T &out) {
+  if constexpr (std::is_same_v<T, bool>) {
+    if (!value.is_boolean()) {
+      return false;
+    }
+    out = value.template get_ref<typename JsonT::boolean_t const &>();
+    return true;
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    if (!value.is_number_integer()) {
+      return false;
+    }
+    int64_t parsed_value = value.template get<int64_t>();
+    if (parsed_value < std::numeric_limits<T>::lowest()) {
+      CRACON_LOG_WARNING("Out of bounds (min)\n");
+      return false;
+    } else if (parsed_value > std::numeric_limits<T>::max()) {
+      CRACON_LOG_WARNING("Out of bounds (max)\n");
+      return false;
+    }
+    out = static_cast<T>(parsed_value);
+    return true;
+  } else if constexpr (std::is_integral_v<T> && std::is_unsigned_v<T>) {
+    if (!value.is_number_integer()) {
+      return false;
+    }
+    int64_t parsed_value = value.template get<int64_t>();
+    if (parsed_value < 0) {
+      CRACON_LOG_WARNING("Out of bounds (min) \n");
+      return false;
+    } else if (static_cast<uint64_t>(parsed_value) >
+               std::numeric_limits<T>::max()) {
+      CRACON_LOG_WARNING("Out of bounds (max)\n");
+      return false;
+    }
+    out = static_cast<T>(parsed_value);
+    return true;
+  } else if constexpr (std::is_floating_point_v<T>) {
+    auto const *parsed_value =
+        value.template get_ptr<typename JsonT::number_float_t const *>();
+    if (parsed_value == nullptr) {
+      return false;
+    }
+    if (*parsed_value < std::numeric_limits<T>::lowest()) {
+      CRACON_LOG_WARNING("Out of bounds (min) \n");
+      return false;
+    } else if (*parsed_value > std::numeric_limits<T>::max()) {
+      CRACON_LOG_WARNING("Out of bounds (max)\n");
+      return false;
+    }
+    out = static_cast<T>(*parsed_value);
+    return true;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    if (!value.is_string()) {
+      return false;
+    }
+    out = value.template get_ref<typename JsonT::string_t const &>();
+    return true;
+  } else if constexpr (is_array<T>::value || is_vector<T>::value) {
+    if (!value.is_array()) {
+      return false;
+    }
+    auto const &elements =
+        value.template get_ref<typename JsonT::array_t const &>();
+    if constexpr (is_array<T>::value) {
+      if (elements.size() != std::tuple_size<T>::value) {
+        return false;
+      }
+    } else {
+      out.resize(elements.size());
+    }
+    for (std::size_t i = 0; i < elements.size(); i++) {
+      if constexpr (std::is_same_v<typename T::value_type, bool>) {
+        // std::vector<bool> elements are not addressable
+        bool element = false;
+        if (!try_get(elements[i], element)) {
+          return false;
+        }
+        out[i] = element;
+      } else if (!try_get(elements[i], out[i])) {
+        return false;
+      }
+    }
+    return true;
+  } else {
+    if (!is_similar<T>(value)) {
+      return false;
+    }
+    out = value.template get<T>();
+    return true;
+  }
+}
+
+/**
+ * @brief Checks if the JSON value holds the same value as `other`.
+ *
+ * Unlike `value == JsonT(other)`, this doesn't allocate a JSON copy of
+ * strings, vectors and arrays.
+ *
+ * @tparam T Type of the compared value
+ * @param value The JSON value to compare
+ * @param other The value to compare to
+ * @return true Both are equal
+ * @return false The type or the value differs
+ */
+template <typename T, typename JsonT>
+bool is_equal(JsonT const &value, T const &other) {
+  if constexpr (std::is_floating_point_v<T>) {
+    // json equality holds for 1 and 1.0, a default changing between integer
+    // and floating point must still be written.
+    return value.is_number_float() && value == other;
+  } else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+    return !value.is_number_float() && value == other;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    return value.is_string() &&
+           value.template get_ref<typename JsonT::string_t const &>() == other;
+  } else if constexpr (is_array<T>::value || is_vector<T>::value) {
+    if (!value.is_array() || value.size() != other.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < other.size(); i++) {
+      if (!is_equal(value[i], other[i])) {
+        return false;
+      }
+    }
+    return true;
+  } else {
+    return value == JsonT(other);
+  }
+}
 }  // namespace cracon
 
 #endif  // CRACON_SIMILARITY_TRAIT_HPP
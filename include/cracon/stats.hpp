@@ -0,0 +1,73 @@
+#ifndef CRACON_STATS_HPP
+#define CRACON_STATS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace cracon {
+
+/**
+ * @brief Distribution of durations in power of two buckets.
+ *
+ * buckets[0] counts the durations under 1ns, buckets[i] those within
+ * [2^(i-1), 2^i) nanoseconds. The last bucket also counts longer durations.
+ */
+struct Histogram {
+  static constexpr std::size_t kBuckets = 40;
+  std::array<std::uint64_t, kBuckets> buckets{};
+
+  /**
+   * @brief Number of durations recorded.
+   */
+  [[nodiscard]] std::uint64_t count() const {
+    std::uint64_t total = 0;
+    for (auto bucket : buckets) {
+      total += bucket;
+    }
+    return total;
+  }
+
+  /**
+   * @brief Upper bound of the duration of bucket i.
+   */
+  [[nodiscard]] static std::chrono::nanoseconds upper_bound(std::size_t i) {
+    return std::chrono::nanoseconds(std::uint64_t{1} << i);
+  }
+};
+
+namespace detail {
+/**
+ * @brief Histogram recorded concurrently with relaxed atomics.
+ */
+class AtomicHistogram {
+ public:
+  void record(std::chrono::nanoseconds duration) {
+    auto nanoseconds = static_cast<std::uint64_t>(
+        duration.count() > 0 ? duration.count() : 0);
+    std::size_t bucket = 0;
+    while (nanoseconds != 0 && bucket + 1 < Histogram::kBuckets) {
+      nanoseconds >>= 1;
+      bucket++;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] Histogram load() const {
+    Histogram histogram;
+    for (std::size_t i = 0; i < Histogram::kBuckets; i++) {
+      histogram.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+  }
+
+ private:
+  std::array<std::atomic<std::uint64_t>, Histogram::kBuckets> buckets_{};
+};
+}  // namespace detail
+
+}  // namespace cracon
+
+#endif  // CRACON_STATS_HPP
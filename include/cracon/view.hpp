@@ -0,0 +1,104 @@
+#ifndef CRACON_VIEW_HPP
+#define CRACON_VIEW_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <type_traits>
+
+namespace cracon {
+
+/**
+ * @brief Read-only view over a JSON array of numbers or booleans.
+ *
+ * Elements are converted to T when accessed, nothing is copied nor allocated.
+ * The array must outlive the view, see File::get_view.
+ *
+ * @tparam JsonT The JSON type of the File, see basic_File.
+ */
+template <typename T, typename JsonT = nlohmann::json>
+class ArrayView {
+  static_assert(std::is_arithmetic_v<T>,
+                "ArrayView is restricted to numbers and booleans");
+
+ public:
+  using value_type = T;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = T;
+
+    const_iterator() = default;
+    explicit const_iterator(JsonT const *element)
+        : element_(element) {}
+
+    T operator*() const { return element_->template get<T>(); }
+    T operator[](difference_type i) const { return *(*this + i); }
+    const_iterator &operator++() {
+      ++element_;
+      return *this;
+    }
+    const_iterator operator++(int) { return const_iterator(element_++); }
+    const_iterator &operator--() {
+      --element_;
+      return *this;
+    }
+    const_iterator operator--(int) { return const_iterator(element_--); }
+    const_iterator &operator+=(difference_type n) {
+      element_ += n;
+      return *this;
+    }
+    const_iterator &operator-=(difference_type n) {
+      element_ -= n;
+      return *this;
+    }
+    const_iterator operator+(difference_type n) const {
+      return const_iterator(element_ + n);
+    }
+    const_iterator operator-(difference_type n) const {
+      return const_iterator(element_ - n);
+    }
+    difference_type operator-(const_iterator const &other) const {
+      return element_ - other.element_;
+    }
+    bool operator==(const_iterator const &other) const {
+      return element_ == other.element_;
+    }
+    bool operator!=(const_iterator const &other) const {
+      return element_ != other.element_;
+    }
+    bool operator<(const_iterator const &other) const {
+      return element_ < other.element_;
+    }
+
+   private:
+    JsonT const *element_ = nullptr;
+  };
+
+  ArrayView() = default;
+  explicit ArrayView(typename JsonT::array_t const &elements)
+      : data_(elements.data()), size_(elements.size()) {}
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  T operator[](std::size_t i) const { return data_[i].template get<T>(); }
+  const_iterator begin() const { return const_iterator(data_); }
+  const_iterator end() const { return const_iterator(data_ + size_); }
+
+ private:
+  JsonT const *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+template <typename T>
+struct is_array_view : public std::false_type {};
+template <typename T, typename JsonT>
+struct is_array_view<ArrayView<T, JsonT>> : public std::true_type {};
+
+}  // namespace cracon
+
+#endif  // CRACON_VIEW_HPP
@@ -0,0 +1,99 @@
+#include "cracon/arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+namespace cracon {
+
+namespace {
+thread_local Arena *current_arena = nullptr;
+
+// Keeps the blocks aligned as operator new would.
+constexpr std::size_t kHeader = alignof(std::max_align_t);
+static_assert(kHeader >= sizeof(Arena *));
+}  // namespace
+
+struct Arena::Block {
+  Block *previous;
+  std::size_t size;
+  // May exceed size: the allocations which don't fit bump it as well.
+  std::atomic<std::size_t> used;
+
+  // Bytes before the data, which stays aligned.
+  static constexpr std::size_t header() {
+    return (sizeof(Block) + kHeader - 1) / kHeader * kHeader;
+  }
+  char *data() { return reinterpret_cast<char *>(this) + header(); }
+};
+
+Arena::~Arena() {
+  for (auto *block = current_.load(); block != nullptr;) {
+    auto *previous = block->previous;
+    block->~Block();
+    ::operator delete(block);
+    block = previous;
+  }
+}
+
+void *Arena::allocate(std::size_t size, std::size_t alignment) {
+  assert(alignment <= kHeader);
+  (void)alignment;
+  // Keeps the next allocation aligned.
+  size = (size + kHeader - 1) / kHeader * kHeader;
+  while (true) {
+    auto *block = current_.load(std::memory_order_acquire);
+    if (block != nullptr) {
+      auto const offset =
+          block->used.fetch_add(size, std::memory_order_relaxed);
+      if (offset + size <= block->size) {
+        allocated_.fetch_add(size, std::memory_order_relaxed);
+        return block->data() + offset;
+      }
+    }
+    grow(block, size);
+  }
+}
+
+void Arena::grow(Block *full, std::size_t size) {
+  std::unique_lock lock(mutex_);
+  if (current_.load(std::memory_order_relaxed) != full) {
+    return;
+  }
+  auto const capacity = std::max(next_size_, size);
+  next_size_ = capacity * 2;
+  auto *memory = ::operator new(Block::header() + capacity);
+  current_.store(new (memory) Block{full, capacity, {0}},
+                 std::memory_order_release);
+}
+
+ArenaScope::ArenaScope(Arena &arena) : previous_(current_arena) {
+  current_arena = &arena;
+}
+
+ArenaScope::~ArenaScope() { current_arena = previous_; }
+
+namespace detail {
+void *arena_allocate(std::size_t size) {
+  auto *arena = current_arena;
+  auto *block =
+      static_cast<char *>(arena != nullptr
+                              ? arena->allocate(kHeader + size, kHeader)
+                              : ::operator new(kHeader + size));
+  *reinterpret_cast<Arena **>(block) = arena;
+  return block + kHeader;
+}
+
+void arena_deallocate(void *pointer) noexcept {
+  if (pointer == nullptr) {
+    return;
+  }
+  auto *block = static_cast<char *>(pointer) - kHeader;
+  if (*reinterpret_cast<Arena **>(block) == nullptr) {
+    ::operator delete(block);
+  }
+  // Blocks of an arena are reclaimed with it.
+}
+}  // namespace detail
+
+}  // namespace cracon
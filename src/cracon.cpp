@@ -1,84 +1,105 @@
-#include "cracon/cracon.hpp"
+#include "cracon/cracon_impl.hpp"
 
-#include <cassert>
-#include <exception>
 #include <fstream>
 
-#include "nlohmann/json.hpp"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace cracon {
 
-File::File(std::string const &filename_config,
-           std::string const &filename_default) {
-  init(filename_config, filename_default);
-}
-
-bool File::write() {
-  std::unique_lock lock(mutex_);
-  if (should_write_config_) {
-    if (write_to_file(filename_config_, config_)) {
-      should_write_config_ = false;
-    }
+namespace detail {
+bool read_file(std::string const &filename, std::string &content,
+               std::ios::openmode mode) {
+  std::ifstream file(filename, mode);
+  if (!file.good()) {
+    return false;
   }
-  if (should_write_default_) {
-    if (write_to_file(filename_default_, default_)) {
-      should_write_default_ = false;
-    }
+  file.seekg(0, std::ios::end);
+  auto const size = file.tellg();
+  file.seekg(0, std::ios::beg);
+  if (size <= 0) {
+    content.clear();
+    return true;
   }
+  content.resize(static_cast<std::size_t>(size));
+  file.read(content.data(), size);
+  // Text mode can read less than the size, i.e. \r\n on Windows
+  content.resize(static_cast<std::size_t>(file.gcount()));
+  return true;
+}
 
-  return !should_write();
+std::string sidecar_filename(std::string const &filename, Sidecar sidecar) {
+  return filename + (sidecar == Sidecar::cbor ? ".cbor" : ".msgpack");
 }
 
-bool File::write_to_file(std::string const &filename,
-                         nlohmann::json const &config) {
-  try {
-    if (filename.empty()) {
-      CRACON_LOG_ERROR("The filename is not set, did you init?\n");
-      assert(false);
-      return false;
-    }
-    std::ofstream output_file(filename);
-    output_file << config.dump(4) << std::endl;
-    output_file.close();
-    return true;
-  } catch (std::exception const &ex) {
-    CRACON_LOG_ERROR("Error writing the file %s: %s\n", filename.c_str(),
-                     ex.what());
-    (void)ex;
-    return false;
-  }
+std::string module_filename(std::string const &directory,
+                            std::string const &name) {
+  return (std::filesystem::path(directory) / (name + ".json")).string();
 }
 
-bool File::init(std::string const &filename_config,
-                std::string const &filename_default) {
-  {
-    std::unique_lock lock(mutex_);
-    filename_config_ = filename_config;
-    filename_default_ = filename_default;
-    config_ = nlohmann::json::object();
-    std::ifstream file(filename_config);
-    if (file.good()) {
-      config_ = nlohmann::json::parse(file);
-      if (config_.is_null()) {
-        config_ = nlohmann::json::object();
-      }
-    }
+void check_module_name(std::string const &name) {
+  if (name.empty() || name.find('/') != std::string::npos) {
+    throw std::invalid_argument("The module " + name + " can't be a file");
   }
-  return write();
 }
 
-SharedFile::SharedFile(std::string const &filename_config,
-                       std::string const &filename_default) {
-  init(filename_config, filename_default);
+std::shared_ptr<MappedFile const> MappedFile::open(
+    std::string const &filename) {
+  auto file = std::make_shared<MappedFile>();
+#if defined(__unix__) || defined(__APPLE__)
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return nullptr;
+  }
+  file->size_ = static_cast<std::size_t>(info.st_size);
+  if (file->size_ > 0) {
+    void *data = mmap(nullptr, file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return nullptr;
+    }
+    file->data_ = static_cast<char const *>(data);
+    file->mapped_ = true;
+  }
+  close(fd);
+#else
+  std::ifstream input(filename, std::ios::in | std::ios::binary);
+  if (!input.good()) {
+    return nullptr;
+  }
+  input.seekg(0, std::ios::end);
+  file->size_ = static_cast<std::size_t>(input.tellg());
+  input.seekg(0, std::ios::beg);
+  file->buffer_ = std::make_unique<char[]>(file->size_);
+  input.read(file->buffer_.get(), static_cast<std::streamsize>(file->size_));
+  file->data_ = file->buffer_.get();
+#endif
+  return file;
 }
 
-bool SharedFile::init(std::string const &filename_config,
-                      std::string const &filename_default) {
-  return file_->init(filename_config, filename_default);
+MappedFile::~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapped_) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+#endif
 }
+}  // namespace detail
 
-bool SharedFile::should_write() { return file_->should_write(); }
-
-bool SharedFile::write() { return file_->write(); }
+template class basic_File<nlohmann::json>;
+template class basic_File<nlohmann::ordered_json>;
+template class basic_File<ArenaJson>;
+template class basic_SharedFile<nlohmann::json>;
+template class basic_SharedFile<nlohmann::ordered_json>;
+template class basic_SharedFile<ArenaJson>;
 
 }  // namespace cracon
@@ -0,0 +1,213 @@
+#include "cracon/log.hpp"
+
+#include <chrono>
+#include <cstdarg>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace cracon {
+
+namespace {
+char const *level_name(LogLevel level) {
+  switch (level) {
+    case LogLevel::debug:
+      return "DEBUG";
+    case LogLevel::info:
+      return "INFO";
+    case LogLevel::warning:
+      return "WARN";
+    default:
+      return "ERROR";
+  }
+}
+
+void default_sink(LogLevel level, char const *message) {
+  fprintf(level >= LogLevel::warning ? stderr : stdout, "[cracon] [%s] %s",
+          level_name(level), message);
+}
+
+// Replaced, never modified. Loaded atomically by the loggers. Constructed on
+// first use, as static objects of other translation units may log.
+std::shared_ptr<LogSink const> &current_sink() {
+  static std::shared_ptr<LogSink const> sink =
+      std::make_shared<LogSink const>(default_sink);
+  return sink;
+}
+std::atomic<std::uint32_t> rate_limit_ = 10;
+
+// Messages of a statement about a key within the current second. Statements
+// and keys hashed to the same slot share their budget, which is rare enough.
+struct RateSlot {
+  std::atomic<std::int64_t> second = -1;
+  std::atomic<std::uint32_t> count = 0;
+};
+constexpr std::size_t kRateSlots = 1024;
+RateSlot rate_slots[kRateSlots];
+
+RateSlot &rate_slot(void const *statement, std::uint64_t key) {
+  // splitmix64 finalizer, spreading the statement addresses and the keys.
+  auto hash = static_cast<std::uint64_t>(
+                  reinterpret_cast<std::uintptr_t>(statement)) ^
+              (key * 0x9e3779b97f4a7c15ULL);
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+  hash ^= hash >> 31;
+  return rate_slots[hash % kRateSlots];
+}
+
+// Bounded multi-producer queue (Vyukov), each slot holding a message.
+class AsyncLogSink {
+ public:
+  AsyncLogSink(LogSink sink, std::size_t capacity)
+      : sink_(std::move(sink)), slots_(round_up(capacity)) {
+    for (std::size_t i = 0; i < slots_.size(); i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    thread_ = std::thread(&AsyncLogSink::run, this);
+  }
+
+  ~AsyncLogSink() {
+    stop_ = true;
+    thread_.join();
+  }
+
+  void push(LogLevel level, char const *message) {
+    auto const mask = slots_.size() - 1;
+    auto position = enqueue_.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while (true) {
+      slot = &slots_[position & mask];
+      auto const sequence = slot->sequence.load(std::memory_order_acquire);
+      if (sequence == position) {
+        if (enqueue_.compare_exchange_weak(position, position + 1,
+                                           std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (static_cast<std::ptrdiff_t>(sequence - position) < 0) {
+        // Full
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      } else {
+        position = enqueue_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->level = level;
+    snprintf(slot->message, sizeof(slot->message), "%s", message);
+    slot->sequence.store(position + 1, std::memory_order_release);
+  }
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    LogLevel level;
+    char message[256];
+  };
+
+  static std::size_t round_up(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  // Forwards the queued messages, false if there were none.
+  bool drain() {
+    auto const mask = slots_.size() - 1;
+    bool forwarded = false;
+    while (true) {
+      auto &slot = slots_[dequeue_ & mask];
+      if (slot.sequence.load(std::memory_order_acquire) != dequeue_ + 1) {
+        break;
+      }
+      sink_(slot.level, slot.message);
+      slot.sequence.store(dequeue_ + slots_.size(), std::memory_order_release);
+      dequeue_++;
+      forwarded = true;
+    }
+    if (auto const dropped = dropped_.exchange(0, std::memory_order_relaxed)) {
+      char message[64];
+      snprintf(message, sizeof(message), "%zu log messages dropped\n",
+               dropped);
+      sink_(LogLevel::warning, message);
+    }
+    return forwarded;
+  }
+
+  void run() {
+    while (!stop_) {
+      if (!drain()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    drain();
+  }
+
+  LogSink sink_;
+  std::vector<Slot> slots_;
+  std::atomic<std::size_t> enqueue_ = 0;
+  // Only used by the background thread.
+  std::size_t dequeue_ = 0;
+  std::atomic<std::size_t> dropped_ = 0;
+  std::atomic<bool> stop_ = false;
+  std::thread thread_;
+};
+}  // namespace
+
+void set_log_sink(LogSink sink) {
+  if (!sink) {
+    sink = default_sink;
+  }
+  std::atomic_store(&current_sink(),
+                    std::make_shared<LogSink const>(std::move(sink)));
+}
+
+void set_log_level(LogLevel level) {
+  detail::log_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void set_log_rate_limit(std::uint32_t messages_per_second) {
+  rate_limit_.store(messages_per_second, std::memory_order_relaxed);
+}
+
+LogSink make_async_log_sink(LogSink sink, std::size_t capacity) {
+  auto async = std::make_shared<AsyncLogSink>(std::move(sink), capacity);
+  return [async](LogLevel level, char const *message) {
+    async->push(level, message);
+  };
+}
+
+namespace detail {
+std::atomic<int> log_level = static_cast<int>(LogLevel::debug);
+
+void log(LogLevel level, char const *format, ...) {
+  char message[512];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+  auto const current = std::atomic_load(&current_sink());
+  (*current)(level, message);
+}
+
+bool log_allowed(void const *statement, std::uint64_t key) {
+  auto const limit = rate_limit_.load(std::memory_order_relaxed);
+  if (limit == 0) {
+    return true;
+  }
+  auto &slot = rate_slot(statement, key);
+  auto const second = std::chrono::duration_cast<std::chrono::seconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  auto previous = slot.second.load(std::memory_order_relaxed);
+  if (previous != second &&
+      slot.second.compare_exchange_strong(previous, second,
+                                          std::memory_order_relaxed)) {
+    slot.count.store(0, std::memory_order_relaxed);
+  }
+  return slot.count.fetch_add(1, std::memory_order_relaxed) < limit;
+}
+}  // namespace detail
+
+}  // namespace cracon
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cracon/arena.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+char const *const kConfig = R"({
+  "car": {"speed": 10, "name": "a name longer than the small string buffer"},
+  "table": [0.0, 0.25, 0.5, 0.75],
+  "nested": {"a": {"b": {"c": true}}}
+})";
+}  // namespace
+
+TEST(ArenaTest, parse_in_arena) {
+  cracon::Arena arena;
+  cracon::ArenaScope scope(arena);
+  auto const config = cracon::ArenaJson::parse(kConfig);
+  EXPECT_GT(arena.allocated(), 0U);
+  EXPECT_EQ(config.dump(), nlohmann::json::parse(kConfig).dump());
+  EXPECT_EQ(config["car"]["speed"].get<int>(), 10);
+  EXPECT_EQ(config["table"][1].get<double>(), 0.25);
+}
+
+TEST(ArenaTest, scopes) {
+  cracon::ArenaJson copy;
+  {
+    auto arena = std::make_unique<cracon::Arena>();
+    {
+      cracon::ArenaScope scope(*arena);
+      auto const config = cracon::ArenaJson::parse(kConfig);
+      {
+        cracon::Arena other;
+        cracon::ArenaScope other_scope(other);
+        auto const before = arena->allocated();
+        auto const table = config["table"];
+        EXPECT_EQ(arena->allocated(), before) << "Allocated in the inner scope";
+        EXPECT_GT(other.allocated(), 0U);
+      }
+      auto const before = arena->allocated();
+      auto const inside = config["nested"];
+      EXPECT_GT(arena->allocated(), before) << "The outer scope is restored";
+
+      // Outside of any scope, on the heap.
+      std::thread([&] { copy = config; }).join();
+    }
+    arena.reset();
+  }
+  EXPECT_EQ(copy.dump(), nlohmann::json::parse(kConfig).dump())
+      << "The copy outlives the arena";
+}
+
+TEST(ArenaTest, shared_by_threads) {
+  cracon::Arena arena;
+  std::vector<cracon::ArenaJson> configs(4);
+  std::vector<std::thread> threads;
+  for (auto &config : configs) {
+    threads.emplace_back([&arena, &config] {
+      cracon::ArenaScope scope(arena);
+      for (int i = 0; i < 100; i++) {
+        config = cracon::ArenaJson::parse(kConfig);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto const &config : configs) {
+    EXPECT_EQ(config.dump(), nlohmann::json::parse(kConfig).dump());
+  }
+}
+
+TEST(ArenaTest, blocks) {
+  cracon::Arena arena(64);
+  std::vector<char *> blocks;
+  for (std::size_t size : {1, 48, 1000, 16, 100000, 3}) {
+    auto *block = static_cast<char *>(arena.allocate(size, 16));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(block) % 16, 0U);
+    std::fill(block, block + size, 'x');
+    blocks.push_back(block);
+  }
+  EXPECT_GE(arena.allocated(), 1U + 48 + 1000 + 16 + 100000 + 3);
+  std::sort(blocks.begin(), blocks.end());
+  EXPECT_EQ(std::unique(blocks.begin(), blocks.end()), blocks.end());
+}
@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <cracon/cracon.hpp>
+#include <filesystem>
 #include <string>
+#include <thread>
 #include <vector>
 
 std::string current_folder = "";
@@ -240,6 +243,688 @@ TEST(FileTest, getters_changes_defaults) {
 */
 }
 
+TEST(FileTest, precompiled_key) {
+  cracon::File file;
+  bool success = file.init(current_folder + "/static_test_data.json",
+                           current_folder + "/static_test_data_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  cracon::Key const key("/this/is/pretty/deep");
+  EXPECT_EQ(file.get(key, 500), 42);
+  EXPECT_EQ(file.get(cracon::Key("/this/is") / "pretty/deep", 500), 42);
+  EXPECT_EQ(key, cracon::Key("/this") / cracon::Key("/is/pretty/deep"));
+  EXPECT_EQ(key.str(), "/this/is/pretty/deep");
+
+  cracon::Key const missing("/nonexisting/key");
+  EXPECT_EQ(file.get(missing, 500), 500);
+  EXPECT_EQ(file.set(missing, 1000), 1000);
+  EXPECT_EQ(file.get(missing, 500), 1000);
+
+  EXPECT_THROW(cracon::Key("no_leading_slash"), nlohmann::json::parse_error);
+
+  auto const child = cracon::Key("/a") / "b~1c/d~0e";
+  cracon::Key const parsed("/a/b~1c/d~0e");
+  EXPECT_EQ(child.pointer(), parsed.pointer());
+  EXPECT_EQ(child.tokens(), parsed.tokens());
+  EXPECT_EQ(child.hash(), parsed.hash());
+  EXPECT_EQ((cracon::Key() / "a").str(), "/a");
+  EXPECT_THROW((void)(cracon::Key("/a") / "b~2"), nlohmann::json::parse_error);
+}
+
+static_assert(cracon::detail::is_valid_pointer(""));
+static_assert(cracon::detail::is_valid_pointer("/a~0b/c~1d"));
+static_assert(!cracon::detail::is_valid_pointer("no_leading_slash"));
+static_assert(!cracon::detail::is_valid_pointer("/bad~2escape"));
+static_assert(!cracon::detail::is_valid_pointer("/trailing~"));
+
+TEST(FileTest, compile_time_key) {
+  cracon::File file;
+  bool success = file.init(current_folder + "/static_test_data.json",
+                           current_folder + "/static_test_data_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  auto const &key = CRACON_KEY("/this/is/pretty/deep");
+  EXPECT_EQ(file.get(key, 500), 42);
+  EXPECT_EQ(key.hash(), cracon::detail::fnv1a("/this/is/pretty/deep"));
+  cracon::Key const *first = nullptr;
+  for (int i = 0; i < 2; i++) {
+    auto const *current = &CRACON_KEY("/this/is/pretty/deep");
+    if (first == nullptr) {
+      first = current;
+    }
+    EXPECT_EQ(current, first) << "Each use site builds its key once";
+  }
+#if defined(__cpp_nontype_template_args) && \
+    __cpp_nontype_template_args >= 201911L
+  EXPECT_EQ(&cracon::key<"/this/is/pretty/deep">(),
+            &cracon::key<"/this/is/pretty/deep">());
+  EXPECT_EQ(file.get(cracon::key<"/this/is/pretty/deep">(), 500), 42);
+#endif
+}
+
+TEST(FileTest, snapshots) {
+  std::string filename = current_folder + "/output_snapshots.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::File file;
+  bool success =
+      file.init(filename, current_folder + "/output_snapshots_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  auto before = file.snapshot();
+  auto generation = file.generation();
+  EXPECT_EQ(file.set("/value", 42), 42);
+  EXPECT_EQ(file.generation(), generation + 1);
+  EXPECT_FALSE(before->config().contains("value"))
+      << "A held snapshot is never modified";
+  EXPECT_EQ(file.snapshot()->config()["value"], 42);
+}
+
+TEST(FileTest, concurrent_readers_and_writer) {
+  std::string filename = current_folder + "/output_concurrent.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::File file;
+  bool success =
+      file.init(filename, current_folder + "/output_concurrent_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  std::vector<int> const first(64, 1);
+  std::vector<int> const second(64, 2);
+  (void)file.set("/vector", first);
+
+  std::atomic<bool> done = false;
+  std::atomic<int> torn = 0;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&] {
+      while (!done) {
+        auto val = file.get("/vector", std::vector<int>{});
+        if (val != first && val != second) {
+          torn++;
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 1000; i++) {
+    (void)file.set("/vector", i % 2 ? first : second);
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(torn, 0);
+}
+
+TEST(FileTest, find_without_throwing) {
+  auto json = nlohmann::json::parse(
+      R"({"a": {"b/c": [10, {"d~e": 42}]}, "scalar": 1})");
+  auto const *val = cracon::find(json, cracon::Key("/a/b~1c/1/d~0e"));
+  ASSERT_NE(val, nullptr);
+  EXPECT_EQ(*val, 42);
+  val = cracon::find(json, cracon::Key("/a/b~1c/0"));
+  ASSERT_NE(val, nullptr);
+  EXPECT_EQ(*val, 10);
+  EXPECT_EQ(cracon::find(json, cracon::Key()), &json);
+  EXPECT_EQ(cracon::find(json, cracon::Key("/a/missing")), nullptr);
+  EXPECT_EQ(cracon::find(json, cracon::Key("/a/b~1c/2")), nullptr);
+  EXPECT_EQ(cracon::find(json, cracon::Key("/a/b~1c/01")), nullptr);
+  EXPECT_EQ(cracon::find(json, cracon::Key("/a/b~1c/18446744073709551617")),
+            nullptr)
+      << "Wraps around to 1 without an overflow check";
+  EXPECT_EQ(cracon::find(json, cracon::Key("/a/b~1c/-")), nullptr);
+  EXPECT_EQ(cracon::find(json, cracon::Key("/scalar/child")), nullptr);
+}
+
+TEST(FileTest, indexed_lookups) {
+  std::string filename = current_folder + "/output_indexed.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::Options options;
+  options.index = true;
+  cracon::File file;
+  bool success = file.init(
+      filename, current_folder + "/output_indexed_default.json", options);
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  EXPECT_EQ(file.get("/deep/a~1b/c", 500), 500);
+  EXPECT_EQ(file.set("/deep/a~1b/c", 42), 42);
+  EXPECT_EQ(file.get("/deep/a~1b/c", 500), 42);
+  std::vector<int> const array{1, 2, 3};
+  EXPECT_EQ(file.set("/deep/array", array), array);
+  EXPECT_EQ(file.get("/deep/array/2", 500), 3);
+  EXPECT_EQ(file.get("/deep/array/3", 500), 500);
+
+  auto snapshot = file.snapshot();
+  EXPECT_TRUE(snapshot->modules.at("deep")->indexed);
+  EXPECT_EQ(snapshot->find(cracon::Key("/deep/a~1b/c")),
+            &(*snapshot->modules.at("deep")->value)["a/b"]["c"]);
+  EXPECT_TRUE(file.write());
+
+  success = file.init(
+      filename, current_folder + "/output_indexed_default.json", options);
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  EXPECT_EQ(file.get("/deep/a~1b/c", 500), 42) << "Indexed at init";
+}
+
+TEST(FileTest, defaults_only_dirty_on_change) {
+  std::string filename = current_folder + "/output_defaults_dirty.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::File file;
+  bool success = file.init(
+      filename, current_folder + "/output_defaults_dirty_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  std::vector<float> const curve{1., 2., 3.};
+  (void)file.get("/curve", curve);
+  EXPECT_TRUE(file.should_write());
+  EXPECT_TRUE(file.write());
+  (void)file.get("/curve", curve);
+  EXPECT_FALSE(file.should_write()) << "The default didn't change";
+  (void)file.get("/curve", std::vector<float>{1., 2.});
+  EXPECT_TRUE(file.should_write()) << "The default changed";
+  EXPECT_TRUE(file.write());
+  (void)file.get("/gain", 1);
+  EXPECT_TRUE(file.write());
+  (void)file.get("/gain", 1.0);
+  EXPECT_TRUE(file.should_write()) << "The default became a double";
+  EXPECT_TRUE(file.write());
+
+  file.freeze_defaults();
+  EXPECT_EQ(file.get("/frozen", 42), 42);
+  EXPECT_FALSE(file.should_write()) << "Frozen defaults are not recorded";
+}
+
+TEST(FileTest, write_behind) {
+  std::string filename = current_folder + "/output_write_behind.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::Options options;
+  options.write_behind = true;
+  options.write_behind_debounce = std::chrono::milliseconds(10);
+  {
+    cracon::File file;
+    bool success = file.init(
+        filename, current_folder + "/output_write_behind_default.json",
+        options);
+    ASSERT_TRUE(success) << "The config file should be R/W";
+    for (int i = 0; i <= 100; i++) {
+      (void)file.set("/value", i);
+    }
+    EXPECT_TRUE(file.flush().get());
+    EXPECT_FALSE(file.should_write());
+    EXPECT_EQ(nlohmann::json::parse(std::ifstream(filename))["value"], 100);
+
+    (void)file.set("/value", 42);
+  }
+  EXPECT_EQ(nlohmann::json::parse(std::ifstream(filename))["value"], 42)
+      << "Pending changes are written on destruction";
+}
+
+TEST(FileTest, skip_identical_writes) {
+  std::string filename = current_folder + "/output_skip_writes.json";
+  std::string filename_default =
+      current_folder + "/output_skip_writes_default.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  std::remove(filename_default.c_str());
+  {
+    cracon::File file;
+    bool success = file.init(filename, filename_default);
+    ASSERT_TRUE(success) << "The config file should be R/W";
+    EXPECT_EQ(file.stats().writes, 2U) << "Missing files are created";
+    EXPECT_EQ(file.get("/value", 1), 1);
+    EXPECT_EQ(file.set("/value", 42), 42);
+    EXPECT_TRUE(file.write());
+    EXPECT_EQ(file.stats().writes, 4U);
+    EXPECT_EQ(file.set("/value", 42), 42);
+    EXPECT_TRUE(file.should_write());
+    EXPECT_TRUE(file.write());
+    EXPECT_EQ(file.stats().writes, 4U);
+    EXPECT_EQ(file.stats().skipped_writes, 1U);
+  }
+
+  cracon::File file;
+  bool success = file.init(filename, filename_default);
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  EXPECT_EQ(file.get("/value", 1), 42);
+  EXPECT_TRUE(file.write());
+  EXPECT_EQ(file.stats().writes, 0U) << "Nothing changed since the last run";
+  EXPECT_EQ(file.stats().skipped_writes, 1U);
+}
+
+TEST(FileTest, binary_sidecar) {
+  std::string filename = current_folder + "/output_sidecar.json";
+  std::string filename_default =
+      current_folder + "/output_sidecar_default.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  std::remove((filename + ".cbor").c_str());
+  cracon::Options options;
+  options.sidecar = cracon::Sidecar::cbor;
+  {
+    cracon::File file;
+    bool success = file.init(filename, filename_default, options);
+    ASSERT_TRUE(success) << "The config file should be R/W";
+    EXPECT_EQ(file.set("/value", 42), 42);
+    EXPECT_TRUE(file.write());
+  }
+
+  // Tamper the sidecar content to check it is loaded instead of the JSON
+  std::ifstream input(filename + ".cbor", std::ios::binary);
+  auto document = nlohmann::json::from_cbor(input);
+  input.close();
+  ASSERT_EQ(document["config"]["value"], 42);
+  document["config"]["value"] = 69;
+  auto const binary = nlohmann::json::to_cbor(document);
+  std::ofstream(filename + ".cbor", std::ios::binary)
+      .write(reinterpret_cast<char const *>(binary.data()), binary.size());
+  {
+    cracon::File file;
+    bool success = file.init(filename, filename_default, options);
+    ASSERT_TRUE(success) << "The config file should be R/W";
+    EXPECT_EQ(file.get("/value", 0), 69) << "The sidecar is up to date";
+  }
+
+  // Changing the JSON invalidates the sidecar
+  std::ofstream(filename) << R"({"value": 1000})" << std::endl;
+  cracon::File file;
+  bool success = file.init(filename, filename_default, options);
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  EXPECT_EQ(file.get("/value", 0), 1000) << "The sidecar is stale";
+  success = file.init(filename, filename_default, options);
+  EXPECT_EQ(file.get("/value", 0), 1000) << "The sidecar is regenerated";
+}
+
+TEST(FileTest, reload_notifies_changed_keys) {
+  std::string filename = current_folder + "/output_reload.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  std::ofstream(filename) << R"({"a": {"b": 1, "c": 2}, "d": 3})" << std::endl;
+  cracon::File file;
+  bool success =
+      file.init(filename, current_folder + "/output_reload_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  int b = 0, a = 0, d = 0, root = 0;
+  auto sub_b = file.subscribe("/a/b", [&] { b++; });
+  auto sub_a = file.subscribe("/a", [&] { a++; });
+  auto sub_d = file.subscribe("/d", [&] { d++; });
+  auto sub_root = file.subscribe(cracon::Key(), [&] { root++; });
+
+  auto generation = file.generation();
+  EXPECT_TRUE(file.reload());
+  EXPECT_EQ(file.generation(), generation) << "The file didn't change";
+
+  std::ofstream(filename) << R"({"a": {"b": 10, "c": 20}, "d": 3})"
+                          << std::endl;
+  EXPECT_TRUE(file.reload());
+  EXPECT_EQ(file.generation(), generation + 1);
+  EXPECT_EQ(file.get("/a/b", 0), 10);
+  EXPECT_EQ(b, 1);
+  EXPECT_EQ(a, 1) << "Notified once for both of its children";
+  EXPECT_EQ(d, 0) << "Unchanged";
+  EXPECT_EQ(root, 1);
+
+  sub_b.reset();
+  std::ofstream(filename) << R"({"a": 5, "d": 3})" << std::endl;
+  EXPECT_TRUE(file.reload());
+  EXPECT_EQ(b, 1) << "Released subscriptions are not notified";
+  EXPECT_EQ(a, 2);
+
+  std::ofstream(filename) << R"({"a": )" << std::endl;
+  EXPECT_FALSE(file.reload()) << "Invalid files are ignored";
+  EXPECT_EQ(file.get("/a", 0), 5);
+
+  {
+    cracon::File other;
+    sub_root = other.subscribe("/a", [] {});
+  }
+  sub_root.reset();  // Released after its file
+}
+
+TEST(FileTest, transaction) {
+  std::string filename = current_folder + "/output_transaction.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::File file;
+  bool success =
+      file.init(filename, current_folder + "/output_transaction_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  EXPECT_TRUE(file.write());
+  auto generation = file.generation();
+  {
+    auto transaction = file.transaction();
+    for (int i = 0; i < 200; i++) {
+      (void)transaction.set("/values/" + std::to_string(i), i);
+    }
+    EXPECT_FALSE(file.should_write());
+    EXPECT_EQ(transaction.get("/values/100", 0), 100) << "Sees its own sets";
+    EXPECT_EQ(file.get("/values/100", 0), 0) << "Not published yet";
+    transaction.commit();
+    EXPECT_EQ(file.generation(), generation + 1) << "Published at once";
+    EXPECT_EQ(file.get("/values/199", 0), 199);
+    EXPECT_TRUE(file.should_write());
+
+    (void)transaction.set("/values/0", 1000);
+  }
+  EXPECT_EQ(file.get("/values/0", 1), 0) << "Uncommitted sets are discarded";
+  EXPECT_EQ(file.generation(), generation + 1);
+}
+
+TEST(FileTest, views) {
+  std::string filename = current_folder + "/output_views.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::File file;
+  bool success =
+      file.init(filename, current_folder + "/output_views_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  std::string const name(100, 'x');
+  std::vector<float> const table{1.5, 2.5, 3.5};
+  (void)file.set("/name", name);
+  (void)file.set("/table", table);
+
+  auto name_view = file.get_view<std::string_view>("/name");
+  ASSERT_TRUE(name_view);
+  EXPECT_EQ(*name_view, name);
+  auto table_view = file.get_view<cracon::ArrayView<float>>("/table");
+  ASSERT_TRUE(table_view);
+  ASSERT_EQ(table_view->size(), 3UL);
+  EXPECT_EQ((*table_view)[1], 2.5f);
+  EXPECT_EQ(std::vector<float>(table_view->begin(), table_view->end()), table);
+
+  (void)file.set("/name", std::string("other"));
+  EXPECT_EQ(*name_view, name) << "The view keeps its snapshot";
+  EXPECT_EQ(*file.get_view<std::string_view>("/name"), "other");
+
+  EXPECT_FALSE(file.get_view<std::string_view>("/table"));
+  EXPECT_FALSE(file.get_view<std::string_view>("/missing"));
+  EXPECT_FALSE(file.get_view<cracon::ArrayView<int>>("/table"))
+      << "Floats are not ints";
+}
+
+TEST(FileTest, external_blobs) {
+  std::string filename = current_folder + "/output_blobs.json";
+  std::string blob_filename = current_folder + "/output_blobs_curve.f32";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  std::remove(blob_filename.c_str());
+  std::vector<float> curve(10000);
+  for (std::size_t i = 0; i < curve.size(); i++) {
+    curve[i] = static_cast<float>(i) * 0.5f;
+  }
+  {
+    cracon::File file;
+    bool success =
+        file.init(filename, current_folder + "/output_blobs_default.json");
+    ASSERT_TRUE(success) << "The config file should be R/W";
+    EXPECT_FALSE(file.set_blob("/curve", "output_blobs_curve.f32", curve,
+                               {100, 99}))
+        << "The shape doesn't match";
+    EXPECT_TRUE(
+        file.set_blob("/curve", "output_blobs_curve.f32", curve, {100, 100}));
+    EXPECT_TRUE(file.write());
+    auto const writes = file.stats().writes;
+    EXPECT_TRUE(
+        file.set_blob("/curve", "output_blobs_curve.f32", curve, {100, 100}));
+    EXPECT_FALSE(file.should_write());
+    EXPECT_EQ(file.stats().writes, writes) << "The blob didn't change";
+  }
+  auto config = nlohmann::json::parse(std::ifstream(filename));
+  EXPECT_EQ(config["curve"]["$blob"], "output_blobs_curve.f32");
+  EXPECT_EQ(config["curve"]["dtype"], "f32");
+
+  cracon::File file;
+  bool success =
+      file.init(filename, current_folder + "/output_blobs_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  auto blob = file.get_blob<float>("/curve");
+  ASSERT_TRUE(blob);
+  EXPECT_EQ(blob.shape(), std::vector<std::size_t>({100, 100}));
+  EXPECT_EQ(std::vector<float>(blob.begin(), blob.end()), curve);
+  EXPECT_FALSE(file.get_blob<double>("/curve")) << "Wrong dtype";
+  EXPECT_FALSE(file.get_blob<float>("/missing"));
+
+  std::vector<float> const other(10000, 1.f);
+  EXPECT_TRUE(
+      file.set_blob("/curve", "output_blobs_curve.f32", other, {100, 100}));
+  EXPECT_EQ(blob[1], 0.5f) << "Blobs being read keep their data";
+  EXPECT_EQ(file.get_blob<float>("/curve")[1], 1.f);
+
+  // 4 bytes * (2^62 + 10000) wraps around to the size of the file.
+  (void)file.set("/wrapped", nlohmann::json{
+                                 {"$blob", "output_blobs_curve.f32"},
+                                 {"shape", {4611686018427397904ULL}}});
+  EXPECT_FALSE(file.get_blob<float>("/wrapped")) << "The shape overflows";
+}
+
+TEST(FileTest, statistics) {
+  std::string filename = current_folder + "/output_statistics.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  std::ofstream(filename) << R"({"value": 42, "text": "oh hi"})" << std::endl;
+  cracon::File file;
+  bool success =
+      file.init(filename, current_folder + "/output_statistics_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  EXPECT_EQ(file.get("/value", 0), 42);
+  EXPECT_EQ(file.get("/missing", 0), 0);
+  EXPECT_EQ(file.get("/text", 0), 0);
+  (void)file.set("/value", 69);
+  {
+    auto transaction = file.transaction();
+    (void)transaction.set("/a", 1);
+    (void)transaction.set("/b", 2);
+    EXPECT_EQ(transaction.get("/a", 0), 1);
+    transaction.commit();
+  }
+  EXPECT_TRUE(file.write());
+
+  auto const stats = file.stats();
+  EXPECT_EQ(stats.gets, 4U);
+  EXPECT_EQ(stats.hits, 2U);
+  EXPECT_EQ(stats.misses, 1U);
+  EXPECT_EQ(stats.type_mismatches, 1U);
+  EXPECT_EQ(stats.sets, 3U);
+  EXPECT_GT(stats.bytes_written, 0U);
+  EXPECT_EQ(stats.write_latency.count(), 2U) << "At init and afterwards";
+  EXPECT_EQ(stats.lock_wait.count(), 3U)
+      << "init, set and the transaction lock";
+}
+
+TEST(FileTest, concurrent_sets) {
+  std::string filename = current_folder + "/output_concurrent_sets.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::File file;
+  bool success = file.init(
+      filename, current_folder + "/output_concurrent_sets_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  auto const before = file.generation();
+
+  constexpr int kThreads = 8;
+  constexpr int kSets = 200;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&file, t] {
+      auto const key = "/module_" + std::to_string(t) + "/value";
+      for (int i = 1; i <= kSets; i++) {
+        (void)file.set(key, i);
+        ASSERT_GE(file.get(key, 0), i) << "Published once set() returns";
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kThreads; t++) {
+    EXPECT_EQ(file.get("/module_" + std::to_string(t) + "/value", 0), kSets);
+  }
+  EXPECT_LE(file.generation() - before,
+            static_cast<std::uint64_t>(kThreads * kSets));
+  auto const snapshot = file.snapshot();
+  (void)file.set("/module_0/value", 0);
+  EXPECT_EQ(file.snapshot()->modules.at("module_1"),
+            snapshot->modules.at("module_1"))
+      << "Only the module set is copied";
+
+  (void)file.set("/number", 1);
+  EXPECT_THROW((void)file.set("/number/child", 2), nlohmann::json::exception);
+  EXPECT_EQ(file.get("/number", 0), 1) << "The failed set changed nothing";
+}
+
+TEST(FileTest, layers) {
+  std::string const base = current_folder + "/output_layers_base.json";
+  std::string const site = current_folder + "/output_layers_site.json";
+  std::string filename = current_folder + "/output_layers.json";
+  std::ofstream(base)
+      << R"({"motor": {"gain": 1, "limit": 10}, "name": "base", "old": 1})"
+      << std::endl;
+  std::ofstream(site) << R"({"motor": {"gain": 2}, "old": null})"
+                      << std::endl;
+  std::ofstream(filename) << R"({"name": "host"})" << std::endl;
+  cracon::File file;
+  cracon::Options options;
+  options.layers = {base, site, current_folder + "/output_layers_none.json"};
+  bool success = file.init(
+      filename, current_folder + "/output_layers_default.json", options);
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  EXPECT_EQ(file.get("/motor/gain", 0), 2);
+  EXPECT_EQ(file.get("/motor/limit", 0), 10);
+  EXPECT_EQ(file.get("/name", std::string()), "host");
+  EXPECT_FALSE(file.snapshot()->config().contains("old")) << "Removed by null";
+
+  (void)file.set("/motor/limit", 20);
+  EXPECT_EQ(file.get("/motor/limit", 0), 20);
+  EXPECT_EQ(file.get("/motor/gain", 0), 2) << "Merged with the lower layers";
+  (void)file.set("/name", nullptr);
+  EXPECT_FALSE(file.snapshot()->config().contains("name")) << "Removed by null";
+  ASSERT_TRUE(file.write());
+  std::ifstream written(filename);
+  EXPECT_EQ(nlohmann::json::parse(written),
+            nlohmann::json::parse(R"({"motor": {"limit": 20}, "name": null})"))
+      << "Only the top layer is written";
+
+  std::ofstream(filename) << R"({"motor": {"gain": 5}})" << std::endl;
+  ASSERT_TRUE(file.reload());
+  EXPECT_EQ(file.get("/motor/gain", 0), 5);
+  EXPECT_EQ(file.get("/motor/limit", 0), 10);
+  EXPECT_EQ(file.get("/name", std::string()), "base");
+}
+
+TEST(FileTest, layers_replaced_parent) {
+  std::string const base = current_folder + "/output_layers_parent_base.json";
+  std::string filename = current_folder + "/output_layers_parent.json";
+  std::ofstream(base) << R"({"motor": {"gain": 1, "limit": 10}})" << std::endl;
+  std::ofstream(filename) << R"({"motor": null})" << std::endl;
+  cracon::File file;
+  cracon::Options options;
+  options.layers = {base};
+  bool success = file.init(
+      filename, current_folder + "/output_layers_parent_default.json", options);
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  EXPECT_EQ(file.get("/motor/gain", 0), 0) << "Removed by null";
+
+  // The merged view kept up to date by each set is the one merged from scratch.
+  auto const merged = [&] {
+    auto config = nlohmann::json::parse(std::ifstream(base));
+    config.merge_patch(file.snapshot()->file_content());
+    return config;
+  };
+  (void)file.set("/motor/limit", 20);
+  EXPECT_EQ(file.snapshot()->config(), merged());
+  EXPECT_EQ(file.get("/motor/gain", 0), 1);
+  (void)file.set("/motor", nullptr);
+  EXPECT_EQ(file.snapshot()->config(), merged());
+  (void)file.set("/motor/gain", 3);
+  EXPECT_EQ(file.snapshot()->config(), merged());
+  EXPECT_EQ(file.get("/motor/limit", 0), 10);
+}
+
+TEST(FileTest, directory) {
+  std::string const directory = current_folder + "/output_conf.d/";
+  std::filesystem::remove_all(directory);
+  std::filesystem::remove(current_folder + "/output_conf.d_default.json");
+  std::filesystem::create_directories(directory);
+  std::ofstream(directory + "car.json") << R"({"speed": 10})" << std::endl;
+  std::ofstream(directory + "motor.json") << R"({"gain": 2})" << std::endl;
+  std::ofstream(directory + "notes.txt") << "Not a module" << std::endl;
+  cracon::File file;
+  bool success =
+      file.init(directory, current_folder + "/output_conf.d_default.json");
+  ASSERT_TRUE(success) << "The config directory should be R/W";
+  EXPECT_EQ(file.get("/car/speed", 0), 10);
+  EXPECT_EQ(file.get("/motor/gain", 0), 2);
+  EXPECT_FALSE(file.snapshot()->config().contains("notes"));
+
+  auto const writes = file.stats().writes;
+  (void)file.set("/car/speed", 20);
+  (void)file.set("/truck/speed", 5);
+  ASSERT_TRUE(file.write());
+  EXPECT_EQ(file.stats().writes - writes, 3U)
+      << "car.json, truck.json and the defaults, not motor.json";
+  EXPECT_EQ(nlohmann::json::parse(std::ifstream(directory + "car.json")),
+            nlohmann::json::parse(R"({"speed": 20})"));
+  EXPECT_EQ(nlohmann::json::parse(std::ifstream(directory + "truck.json")),
+            nlohmann::json::parse(R"({"speed": 5})"));
+
+  std::ofstream(directory + "motor.json") << R"({"gain": 3})" << std::endl;
+  ASSERT_TRUE(file.reload());
+  EXPECT_EQ(file.get("/motor/gain", 0), 3);
+  EXPECT_EQ(file.get("/car/speed", 0), 20);
+
+  {
+    auto transaction = file.transaction();
+    (void)transaction.set("/motor/gain", 4);
+  }  // Discarded
+  EXPECT_THROW((void)file.set("/motor/gain/x", 1), nlohmann::json::exception);
+  EXPECT_THROW((void)file.set("/a~1b/x", 1), std::invalid_argument)
+      << "a/b.json can't be written";
+  EXPECT_THROW((void)file.set("", nlohmann::json{{"a/b", 1}}),
+               std::invalid_argument);
+  EXPECT_EQ(file.get("/motor/gain", 0), 3) << "The modules weren't replaced";
+  (void)file.set("/car/speed", 30);
+  auto const written = file.stats().writes;
+  ASSERT_TRUE(file.write());
+  EXPECT_EQ(file.stats().writes - written, 1U)
+      << "Only car.json, the changes of motor.json weren't published";
+
+  std::ofstream(directory + "broken.json") << "{" << std::endl;
+  cracon::File broken;
+  EXPECT_THROW(
+      broken.init(directory, current_folder + "/output_conf.d_default.json"),
+      nlohmann::json::exception);
+}
+
+TEST(FileTest, json_types) {
+  std::string filename = current_folder + "/output_json_types.json";
+  std::ofstream(filename) << R"({"zebra": 1, "apple": {"b": 2, "a": 3}})"
+                          << std::endl;
+  {
+    // Keeps the order of the keys when written.
+    cracon::basic_File<nlohmann::ordered_json> file;
+    bool success =
+        file.init(filename, current_folder + "/output_json_types_default.json");
+    ASSERT_TRUE(success) << "The config file should be R/W";
+    EXPECT_EQ(file.get("/apple/a", 0), 3);
+    (void)file.set("/mango", 4);
+    ASSERT_TRUE(file.write());
+    EXPECT_EQ(nlohmann::ordered_json::parse(std::ifstream(filename)).dump(),
+              R"({"zebra":1,"apple":{"b":2,"a":3},"mango":4})");
+    auto view = file.get_view<
+        cracon::ArrayView<double, nlohmann::ordered_json>>("/missing");
+    EXPECT_FALSE(view);
+  }
+  {
+    // Parsed in an arena, held by the snapshot.
+    cracon::basic_SharedFile<cracon::ArenaJson> shared(
+        filename, current_folder + "/output_json_types_default.json");
+    auto param = shared.get_param("/zebra", 0);
+    EXPECT_EQ(param.get(), 1);
+    param.set(5);
+    EXPECT_EQ(shared.get("/zebra", 0), 5);
+    EXPECT_TRUE(shared.write());
+
+    cracon::basic_File<cracon::ArenaJson> file;
+    ASSERT_TRUE(file.init(filename,
+                          current_folder + "/output_json_types_default.json"));
+    auto const snapshot = file.snapshot();
+    auto const arena = snapshot->modules.at("zebra")->arena;
+    ASSERT_NE(arena, nullptr);
+    EXPECT_GT(arena->allocated(), 0U);
+    EXPECT_EQ(file.get("/zebra", 0), 5);
+    (void)file.set("/zebra", 6);
+    EXPECT_EQ(file.snapshot()->modules.at("zebra")->arena, nullptr)
+        << "Copies are on the heap";
+    EXPECT_EQ(file.snapshot()->modules.at("apple")->arena, arena)
+        << "Only the module set is copied";
+    EXPECT_EQ(*snapshot->modules.at("zebra")->value, 5)
+        << "The arena is still held";
+  }
+}
+
 int main(int argc, char **argv) {
   std::string current_file(argv[0]);
   size_t pos = current_file.rfind('/');
@@ -1,14 +1,27 @@
 #include <gtest/gtest.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cracon/cracon.hpp>
+#include <fstream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest-death-test.h"
 
 std::string current_folder = "";
 
+struct Motor {
+  int64_t speed = 9000;
+  double horsepower = 120.;
+  std::array<int, 4> curve = {1, 2, 3, 4};
+  std::string name = "V8";
+};
+CRACON_STRUCT(Motor, speed, horsepower, curve, name)
+
 TEST(GroupTest, setter_and_writer) {
   std::string filename = current_folder + "/group_output_test.json";
   std::remove(filename.c_str());  // Remove the file if it exists
@@ -85,6 +98,135 @@ TEST(GroupTest, param_change_from_ref) {
   file.write();
 }
 
+TEST(GroupTest, precompiled_key) {
+  std::string filename = current_folder + "/group_key_test.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::SharedFile file;
+  bool success =
+      file.init(filename, current_folder + "/group_output_test_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  auto group = file.get_group("car").get_group("motor");
+  cracon::Key const key = group.key("speed");
+  EXPECT_EQ(key.str(), "/car/motor/speed");
+  EXPECT_EQ(group.set("speed", 42), 42);
+  EXPECT_EQ(file.get(key, 1000), 42);
+  auto param = file.get_param(key, 1000);
+  EXPECT_EQ(param.get(), 42);
+}
+
+TEST(GroupTest, struct_binding) {
+  std::string filename = current_folder + "/group_struct_test.json";
+  std::string filename_default =
+      current_folder + "/group_struct_test_default.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  std::remove(filename_default.c_str());
+  std::ofstream(filename) << R"({"car": {"motor": {"speed": 42, "name": 1}}})"
+                          << std::endl;
+  cracon::SharedFile file;
+  bool success = file.init(filename, filename_default);
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  auto group = file.get_group("car").get_group("motor");
+  Motor motor;
+  group.bind(motor);
+  EXPECT_EQ(motor.speed, 42);
+  EXPECT_EQ(motor.horsepower, 120.) << "Missing fields keep their default";
+  EXPECT_EQ(motor.name, "V8") << "Dissimilar fields keep their default";
+  EXPECT_TRUE(file.write());
+
+  auto defaults = nlohmann::json::parse(std::ifstream(filename_default));
+  EXPECT_EQ(defaults["car"]["motor"]["speed"], 9000);
+  EXPECT_EQ(defaults["car"]["motor"]["curve"], nlohmann::json({1, 2, 3, 4}));
+  Motor other;
+  group.bind(other);
+  EXPECT_FALSE(file.should_write()) << "The defaults didn't change";
+
+  motor.horsepower = 300.;
+  motor.curve = {4, 3, 2, 1};
+  group.store(motor);
+  EXPECT_TRUE(file.should_write());
+  EXPECT_EQ(file.get("/car/motor/horsepower", 0.), 300.);
+  Motor loaded;
+  group.bind(loaded);
+  EXPECT_EQ(loaded.curve, motor.curve);
+  EXPECT_EQ(loaded.speed, 42);
+}
+
+TEST(GroupTest, realtime_param_no_tearing) {
+  std::string filename = current_folder + "/group_realtime_test.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::SharedFile file;
+  bool success =
+      file.init(filename, current_folder + "/group_output_test_default.json");
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  using Curve = std::array<int64_t, 32>;
+  Curve first;
+  Curve second;
+  first.fill(1);
+  second.fill(2);
+  auto curve = file.get_group("car").get_realtime_param("curve", first);
+  EXPECT_EQ(curve.get(), first);
+
+  std::atomic<bool> done = false;
+  std::atomic<int> torn = 0;
+  std::atomic<int> reads = 0;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&, reader = curve] {
+      while (!done) {
+        auto const val = reader.get();
+        if (val != first && val != second) {
+          torn++;
+        }
+        reads++;
+      }
+    });
+  }
+  for (int i = 0; i < 2000; i++) {
+    curve.set(i % 2 ? first : second);
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(torn, 0);
+  EXPECT_GT(reads, 0);
+  EXPECT_EQ(curve.get(), first);
+  EXPECT_EQ(file.get("/car/curve", second), first);
+}
+
+#ifdef __linux__
+TEST(GroupTest, watched_param) {
+  std::string filename = current_folder + "/group_watch_test.json";
+  std::remove(filename.c_str());  // Remove the file if it exists
+  cracon::Options options;
+  options.watch = true;
+  cracon::SharedFile file;
+  bool success = file.init(
+      filename, current_folder + "/group_output_test_default.json", options);
+  ASSERT_TRUE(success) << "The config file should be R/W";
+  auto speed = file.get_group("car").get_param("speed", 1000);
+  auto other = file.get_param("/other", 1);
+  auto realtime_speed = file.get_realtime_param("/car/speed", 1000);
+  EXPECT_EQ(speed.get(), 1000);
+
+  std::ofstream(filename) << R"({"car": {"speed": 42}, "other": 1})"
+                          << std::endl;
+  auto const deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (speed.get() != 42 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // Each listener is called in turn, the realtime one may come last.
+  while (realtime_speed.get() != 42 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(speed.get(), 42) << "The external change is reloaded";
+  EXPECT_EQ(other.get(), 1);
+  EXPECT_EQ(realtime_speed.get(), 42);
+}
+#endif
+
 int main(int argc, char** argv) {
   std::string current_file(argv[0]);
   size_t pos = current_file.rfind('/');
@@ -12,9 +12,13 @@ template <typename T>
 void test_all_items(nlohmann::json const &json_data, std::string const &name) {
   for (auto &data : json_data.items()) {
     std::cout << "handling " << data.key() << std::endl;
+    T converted{};
+    EXPECT_EQ(try_get(data.value(), converted), is_similar<T>(data.value()))
+        << data.key() << " is converted if and only if it is similar";
     if (data.key().find(name) != std::string::npos) {
       EXPECT_TRUE(is_similar<T>(data.value()))
           << data.key() << " should be a " << name;
+      EXPECT_EQ(converted, data.value().template get<T>());
     } else {
       EXPECT_FALSE(is_similar<T>(data.value()))
           << data.key() << " should not be a " << name;
@@ -137,6 +141,44 @@ TEST_F(IsSimilarTest, test_array_int_wrong_number) {
   test_all_items<std::array<int, 10>>(json_data_, "matchnone!");
 }
 
+TEST_F(IsSimilarTest, test_is_equal) {
+  EXPECT_TRUE(is_equal(json_data_["int8_unsigned8"], 127));
+  EXPECT_TRUE(is_equal(json_data_["int8_unsigned8"], uint8_t{127}));
+  EXPECT_FALSE(is_equal(json_data_["int8_unsigned8"], 128));
+  EXPECT_TRUE(is_equal(json_data_["float_double_one"], 1.0f));
+  EXPECT_FALSE(is_equal(json_data_["float_double_one"], 1));
+  EXPECT_FALSE(is_equal(json_data_["int8_unsigned8"], 127.0));
+  EXPECT_TRUE(is_equal(nlohmann::json(-1), -1));
+  EXPECT_FALSE(is_equal(nlohmann::json::parse("[1, 2.0]"),
+                        std::vector<int>{1, 2}));
+  EXPECT_TRUE(is_equal(json_data_["bool_true"], true));
+  EXPECT_FALSE(is_equal(json_data_["bool_true"], 1));
+  EXPECT_TRUE(is_equal(json_data_["string_number"], std::string("1")));
+  EXPECT_FALSE(is_equal(json_data_["string_number"], 1));
+  EXPECT_TRUE(is_equal(json_data_["array_i"], std::vector<int>{1, 2, 3}));
+  EXPECT_TRUE(is_equal(json_data_["array_i"], std::array<int, 3>{1, 2, 3}));
+  EXPECT_FALSE(is_equal(json_data_["array_i"], std::vector<int>{1, 2}));
+  EXPECT_TRUE(is_equal(json_data_["array_str"],
+                       std::vector<std::string>{"hey", "oh"}));
+}
+
+TEST_F(IsSimilarTest, test_try_get_large_vector) {
+  std::vector<float> expected(10000);
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    expected[i] = static_cast<float>(i) + 0.5f;
+  }
+  nlohmann::json value = expected;
+  std::vector<float> converted{1.f, 2.f};
+  EXPECT_TRUE(try_get(value, converted));
+  EXPECT_EQ(converted, expected);
+
+  value[5000] = 1;
+  EXPECT_FALSE(try_get(value, converted)) << "An int is not a float";
+  std::vector<bool> bools;
+  EXPECT_TRUE(try_get(nlohmann::json({true, false}), bools));
+  EXPECT_EQ(bools, std::vector<bool>({true, false}));
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cracon/log.hpp>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Recorded {
+  std::mutex mutex;
+  std::vector<std::string> messages;
+
+  cracon::LogSink sink() {
+    return [this](cracon::LogLevel, char const *message) {
+      std::unique_lock lock(mutex);
+      messages.emplace_back(message);
+    };
+  }
+  std::size_t size() {
+    std::unique_lock lock(mutex);
+    return messages.size();
+  }
+};
+
+int evaluated = 0;
+int expensive() { return ++evaluated; }
+}  // namespace
+
+TEST(LogTest, sink_and_level) {
+  Recorded recorded;
+  cracon::set_log_sink(recorded.sink());
+  cracon::set_log_level(cracon::LogLevel::warning);
+  cracon::set_log_rate_limit(0);
+  for (int i = 0; i < 3; i++) {
+    CRACON_LOG_IMPL(cracon::LogLevel::info, "filtered %d\n", expensive());
+    CRACON_LOG_IMPL(cracon::LogLevel::error, "error %d\n", i);
+  }
+  EXPECT_EQ(evaluated, 0) << "Filtered messages are not formatted";
+  ASSERT_EQ(recorded.size(), 3UL);
+  EXPECT_EQ(recorded.messages[2], "error 2\n");
+
+  cracon::set_log_sink(nullptr);
+  cracon::set_log_level(cracon::LogLevel::debug);
+  cracon::set_log_rate_limit(10);
+}
+
+TEST(LogTest, rate_limit) {
+  Recorded recorded;
+  cracon::set_log_sink(recorded.sink());
+  cracon::set_log_rate_limit(5);
+  for (int i = 0; i < 100; i++) {
+    CRACON_LOG_IMPL(cracon::LogLevel::warning, "flood %d\n", expensive());
+  }
+  EXPECT_LE(recorded.size(), 10UL) << "At most 5 per second";
+  EXPECT_GE(recorded.size(), 5UL);
+  EXPECT_EQ(static_cast<std::size_t>(evaluated), recorded.size())
+      << "Limited messages are not formatted";
+  evaluated = 0;
+
+  cracon::set_log_sink(nullptr);
+  cracon::set_log_rate_limit(10);
+}
+
+TEST(LogTest, rate_limit_per_key) {
+  Recorded recorded;
+  cracon::set_log_sink(recorded.sink());
+  cracon::set_log_rate_limit(5);
+  for (std::uint64_t key : {1, 1, 1, 1, 1, 1, 1, 1, 2, 3}) {
+    CRACON_LOG_KEYED_IMPL(cracon::LogLevel::warning, key, "key %d\n",
+                          static_cast<int>(key));
+  }
+  ASSERT_GE(recorded.size(), 7UL);
+  EXPECT_LE(recorded.size(), 10UL);
+  EXPECT_EQ(recorded.messages.back(), "key 3\n")
+      << "A flood about one key doesn't hide the others";
+
+  cracon::set_log_sink(nullptr);
+  cracon::set_log_rate_limit(10);
+}
+
+TEST(LogTest, async_sink) {
+  Recorded recorded;
+  cracon::set_log_rate_limit(0);
+  {
+    cracon::set_log_sink(cracon::make_async_log_sink(recorded.sink(), 4096));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([] {
+        for (int i = 0; i < 500; i++) {
+          CRACON_LOG_IMPL(cracon::LogLevel::info, "message %d\n", i);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    // Releases the async sink, which forwards the queued messages
+    cracon::set_log_sink(nullptr);
+  }
+  EXPECT_EQ(recorded.size(), 2000UL);
+  cracon::set_log_rate_limit(10);
+}
+
+TEST(LogTest, async_sink_drops_when_full) {
+  std::atomic<bool> blocked = true;
+  std::atomic<int> received = 0;
+  auto sink = cracon::make_async_log_sink(
+      [&](cracon::LogLevel, char const *) {
+        while (blocked) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        received++;
+      },
+      8);
+  for (int i = 0; i < 100; i++) {
+    sink(cracon::LogLevel::info, "message\n");
+  }
+  blocked = false;
+  sink = nullptr;
+  EXPECT_LT(received, 100) << "Messages beyond the capacity are dropped";
+  EXPECT_GT(received, 0);
+}